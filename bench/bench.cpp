@@ -0,0 +1,48 @@
+#include "bench.h"
+#include "core.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <new>
+
+unsigned long benchAllocs = 0;
+
+// Every new and new[] comes through here, so a count of calls is a count of
+// the allocations the core makes.
+void* operator new(size_t size) throw(std::bad_alloc) {
+    ++benchAllocs;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+double BenchMicros() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+void BenchList(size_t n) {
+    tasks.clear();
+    titleArena.clear();
+    ResetSearchIndex();
+    ResetViewIndex();
+    ResetUndo();
+    ResetSync();
+    searchQuery.clear();
+    viewOrder = ORDER_LIST;
+    currentMode = MODE_LIST;
+    selectedIndex = 0;
+    nextTaskId = 1;
+    SnapScroll(0);
+    for (size_t i = 0; i < n; ++i) {
+        wchar_t title[32];
+        swprintf(title, 32, L"Task %lu", (unsigned long)i);
+        tasks.push_back(MakeTask(title));
+        tasks.back().completed = i % 3 == 0;
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ * TofuMental - Host benchmark support.
+ * A monotonic clock, a count of heap allocations and a way to fill the core
+ * with a list of a given size, shared by the benchmarks and timing tests.
+ */
+
+#ifndef TOFU_BENCH_H
+#define TOFU_BENCH_H
+
+#include <stddef.h>
+
+extern unsigned long benchAllocs; // operator new calls so far
+
+double BenchMicros();
+
+// Clears the core's list state and fills it with n tasks titled "Task <i>",
+// every third one completed.
+void BenchList(size_t n);
+
+#endif
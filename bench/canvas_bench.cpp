@@ -0,0 +1,101 @@
+/*
+ * TofuMental - Canvas benchmark.
+ * Times each canvas kernel on a panel-sized 480x272 buffer and, where there
+ * is one, against a plain per-pixel loop doing the same work, as the old
+ * SetPixel seam and pixel-at-a-time drawing did.
+ */
+
+#include "canvas.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#define SCREEN_W 480
+#define SCREEN_H 272
+#define TEXT_W 400
+#define TEXT_H 40
+#define RUNS 2000
+
+std::vector<Pixel565> screenBits(SCREEN_W * SCREEN_H);
+std::vector<Pixel565> textBits(TEXT_W * TEXT_H);
+Canvas565 screen;
+Canvas565 text;
+unsigned int blitFade = FADE_ONE;
+
+void FastClear() {
+    screen.FillRect(0, 0, SCREEN_W, SCREEN_H, RGB565(16, 16, 16));
+}
+
+void PlainClear() {
+    for (int y = 0; y < SCREEN_H; ++y) {
+        for (int x = 0; x < SCREEN_W; ++x) screen.Plot(x, y, RGB565(16, 16, 16));
+    }
+}
+
+void FastSeam() {
+    screen.DottedSeam(24, SCREEN_W - 24, 136, 8, RGB565(80, 80, 80), RGB565(160, 160, 160));
+}
+
+void PlainSeam() {
+    for (int x = 24; x < SCREEN_W - 24; ++x) screen.Plot(x, 136, RGB565(80, 80, 80));
+    for (int x = 24; x < SCREEN_W - 24; x += 8) {
+        screen.Plot(x, 134, RGB565(160, 160, 160));
+        screen.Plot(x, 138, RGB565(160, 160, 160));
+    }
+}
+
+void FastBlit() {
+    screen.OrBlitFaded(text, 0, 0, 64, 116, TEXT_W, TEXT_H, blitFade);
+}
+
+void PlainBlit() {
+    for (int y = 0; y < TEXT_H; ++y) {
+        for (int x = 0; x < TEXT_W; ++x) {
+            Pixel565 s = text.Row(y)[x];
+            if (s) screen.Row(116 + y)[64 + x] |= Fade565(s, blitFade);
+        }
+    }
+}
+
+void FastRowFrame() {
+    screen.FillRoundRect(24, 112, SCREEN_W - 24, 160, 8, RGB565(30, 30, 30), RGB565(90, 90, 90));
+}
+
+void FastIndicator() {
+    screen.FillCircle(32, 128, 48, RGB565(200, 200, 200));
+    screen.StrokeCircle(32, 128, 48, RGB565(255, 255, 255));
+}
+
+double TimeKernel(void (*kernel)()) {
+    double start = BenchMicros();
+    for (int k = 0; k < RUNS; ++k) kernel();
+    return (BenchMicros() - start) / RUNS;
+}
+
+void Report(const char* name, void (*fast)(), void (*plain)()) {
+    double f = TimeKernel(fast);
+    if (plain) {
+        double p = TimeKernel(plain);
+        printf("%-16s %10.2f %10.2f %8.1fx\n", name, f, p, p / f);
+    } else {
+        printf("%-16s %10.2f %10s %9s\n", name, f, "-", "-");
+    }
+}
+
+int main() {
+    screen.Attach(&screenBits[0], SCREEN_W, SCREEN_H, SCREEN_W);
+    text.Attach(&textBits[0], TEXT_W, TEXT_H, TEXT_W);
+    srand(1);
+    for (size_t i = 0; i < textBits.size(); ++i) textBits[i] = (Pixel565)(rand() % 4 ? 0 : 0xFFFF); // Sparse, like glyphs
+
+    printf("%-16s %10s %10s %9s\n", "kernel", "us/op", "plain us", "speedup");
+    Report("clear", FastClear, PlainClear);
+    Report("seam", FastSeam, PlainSeam);
+    Report("blit", FastBlit, PlainBlit);
+    blitFade = 20;
+    Report("blit faded", FastBlit, PlainBlit);
+    Report("row frame", FastRowFrame, NULL);
+    Report("indicator", FastIndicator, NULL);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * TofuMental - Frame-time benchmark.
+ * Drives the core the way the window does for a held arrow key, stylus taps
+ * and typing into a new task, over lists of 10 to 100k tasks, and reports per
+ * frame the layout time, heap allocations, rows walked and sink commands.
+ */
+
+#include "core.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SCREEN_W 480
+#define SCREEN_H 272
+#define FRAME_MS 16
+#define REPEAT_MS 33 // Typematic rate of a held key
+#define TAP_MS 300
+#define TYPED_CHARS 40 // Per task before it is committed and another begun
+#define RUN_FRAMES 600
+
+// Reads what a painter would and counts nothing itself; EmitFrame does that.
+class NullSink : public FrameSink {
+public:
+    NullSink() : touched(0) {}
+    void Background(const LayoutRect& r) { touched += r.right; }
+    void FocusFrame(const LayoutRect& r, bool editing) { touched += r.top + editing; }
+    void Seam(int left, int right, int y) { touched += left + right + y; }
+    void Indicator(const LayoutRect& r, bool completed) { touched += r.left + completed; }
+    void RowTitle(const LayoutRect& r, const Task& t, int alpha, bool editing, bool caret) {
+        touched += r.top + t.title.size() + t.title.c_str()[0] + alpha + editing + caret;
+    }
+    void Header(const LayoutRect& r, AppMode mode, const wchar_t* query, const wchar_t* listName) {
+        touched += r.top + mode + query[0] + listName[0];
+    }
+    void Footer(const LayoutRect& r, AppMode mode, size_t count) { touched += r.top + mode + count; }
+
+    unsigned long touched;
+};
+
+enum Scenario { SCENARIO_REPEAT, SCENARIO_TAPS, SCENARIO_TYPING, SCENARIO_COUNT };
+
+const char* scenarioNames[SCENARIO_COUNT] = { "key repeat", "taps", "typing" };
+
+struct FrameTotals {
+    double micros; // In EmitFrame
+    double worst;
+    unsigned long allocs; // Input handling and EmitFrame
+    long rows;
+    long commands;
+};
+
+// Applies the input due by `now` and returns the rect the window would
+// invalidate for it.
+LayoutRect DriveInput(Scenario scenario, int frame, unsigned long now, unsigned long& nextInput) {
+    LayoutRect screen = MakeLayoutRect(0, 0, SCREEN_W, SCREEN_H);
+    if (scenario == SCENARIO_TYPING) {
+        if (frame % TYPED_CHARS == TYPED_CHARS - 1) {
+            CommitAddTask();
+            BeginAddTask();
+            return screen;
+        }
+        EditSelectedTitle((wchar_t)(L'a' + frame % 26));
+        return GetRowRect(SCREEN_W, SCREEN_H, 0);
+    }
+
+    for (; now >= nextInput; nextInput += scenario == SCENARIO_REPEAT ? REPEAT_MS : TAP_MS) {
+        if (scenario == SCENARIO_REPEAT) {
+            if (StepSelection(1)) ScrollTowardIndex(selectedIndex, now);
+        } else {
+            int slot = TapSlot(rand() % SCREEN_H, SCREEN_H);
+            int row = SlotToRow(slot);
+            selectedIndex = WrapIndex(row, (int)ViewSize());
+            ScrollTowardRow(row, now);
+        }
+    }
+    TickScroll(now);
+    return screen;
+}
+
+FrameTotals RunScenario(Scenario scenario) {
+    NullSink sink;
+    FrameTotals totals = { 0, 0, 0, 0, 0 };
+    unsigned long now = 1000;
+    unsigned long nextInput = now;
+    srand(1);
+    if (scenario == SCENARIO_TYPING) BeginAddTask();
+    for (int frame = 0; frame < RUN_FRAMES; ++frame, now += FRAME_MS) {
+        unsigned long allocs = benchAllocs;
+        LayoutRect dirty = DriveInput(scenario, frame, now, nextInput);
+        double start = BenchMicros();
+        FrameStats stats = EmitFrame(sink, SCREEN_W, SCREEN_H, dirty, now);
+        double micros = BenchMicros() - start;
+        totals.micros += micros;
+        if (micros > totals.worst) totals.worst = micros;
+        totals.allocs += benchAllocs - allocs;
+        totals.rows += stats.rowsVisited;
+        totals.commands += stats.commands;
+    }
+    if (scenario == SCENARIO_TYPING) EndAddTask();
+    return totals;
+}
+
+int main() {
+    static const size_t sizes[] = { 10, 100, 1000, 10000, 100000 };
+    printf("%-10s %7s %10s %10s %10s %8s %8s\n", "scenario", "tasks", "us/frame", "worst us", "allocs/fr", "rows/fr", "cmds/fr");
+    for (int s = 0; s < SCENARIO_COUNT; ++s) {
+        for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+            BenchList(sizes[k]);
+            FrameTotals t = RunScenario((Scenario)s);
+            printf("%-10s %7lu %10.2f %10.2f %10.2f %8.1f %8.1f\n", scenarioNames[s], (unsigned long)sizes[k],
+                   t.micros / RUN_FRAMES, t.worst, (double)t.allocs / RUN_FRAMES,
+                   (double)t.rows / RUN_FRAMES, (double)t.commands / RUN_FRAMES);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * TofuMental - Journal benchmark.
+ * Reports the bytes each kind of mutation adds to tasks.log, against the
+ * whole tasks.txt the app rewrote per mutation before the journal, and the
+ * time and allocations to replay a journal of 100k records.
+ */
+
+#include "core.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPLAY_RECORDS 100000
+#define RUNS 5
+
+void PrintMutationBytes() {
+    BenchList(1000);
+    Task& t = tasks[500];
+    t.priority = 2;
+    t.due = 9500;
+
+    static const unsigned char ops[] = { JOP_ADD, JOP_DELETE, JOP_SET_COMPLETED, JOP_SET_TITLE, JOP_SET_PLAN };
+    static const char* names[] = { "add+plan", "delete", "toggle", "rename", "plan" };
+    printf("bytes per mutation of \"%ls\":\n", t.title.c_str());
+    for (size_t i = 0; i < sizeof(ops); ++i) {
+        std::vector<unsigned char> out;
+        EncodeJournalRecord(ops[i], t, out);
+        printf("  %-9s %4lu\n", names[i], (unsigned long)out.size());
+    }
+
+    static const size_t sizes[] = { 10, 1000, 100000 };
+    printf("tasks.txt rewritten per mutation:\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        BenchList(sizes[s]);
+        std::vector<unsigned char> txt;
+        EncodeTextSnapshot(tasks, nextTaskId, txt);
+        printf("  %6lu tasks %8lu\n", (unsigned long)sizes[s], (unsigned long)txt.size());
+    }
+}
+
+// Adds for the first half, then toggles, renames, plans and deletes of them.
+void BuildReplayLog(std::vector<unsigned char>& log) {
+    BenchList(0);
+    size_t adds = REPLAY_RECORDS / 2;
+    for (size_t i = 0; i < adds; ++i) {
+        tasks.push_back(MakeTask(L"Task to replay"));
+        EncodeJournalRecord(JOP_ADD, tasks.back(), log);
+    }
+    srand(1);
+    for (size_t i = adds; i < REPLAY_RECORDS; ++i) {
+        Task& t = tasks[rand() % tasks.size()];
+        switch (rand() % 8) {
+            case 0:
+                t.title = TaskTitle(std::wstring(L"Renamed"));
+                EncodeJournalRecord(JOP_SET_TITLE, t, log);
+                break;
+            case 1:
+                t.priority = 1;
+                EncodeJournalRecord(JOP_SET_PLAN, t, log);
+                break;
+            case 2:
+                EncodeJournalRecord(JOP_DELETE, t, log);
+                break;
+            default:
+                t.completed = !t.completed;
+                EncodeJournalRecord(JOP_SET_COMPLETED, t, log);
+                break;
+        }
+    }
+}
+
+void PrintReplay() {
+    std::vector<unsigned char> log;
+    BuildReplayLog(log);
+    double best = 0;
+    unsigned long allocs = 0;
+    for (int run = 0; run < RUNS; ++run) {
+        tasks.clear();
+        titleArena.clear();
+        std::map<unsigned long, size_t> index;
+        unsigned long before = benchAllocs;
+        double start = BenchMicros();
+        size_t applied = ReplayJournalRecords(&log[0], log.size(), index);
+        double micros = BenchMicros() - start;
+        if (applied != log.size()) printf("replay stopped at %lu of %lu bytes\n", (unsigned long)applied, (unsigned long)log.size());
+        if (run == 0 || micros < best) best = micros;
+        allocs = benchAllocs - before;
+    }
+    printf("replay of %d records (%lu bytes): %.0f us, %.1f ns/record, %lu allocs\n", REPLAY_RECORDS,
+           (unsigned long)log.size(), best, best * 1000 / REPLAY_RECORDS, allocs);
+}
+
+int main() {
+    PrintMutationBytes();
+    PrintReplay();
+    return 0;
+}
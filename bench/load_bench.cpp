@@ -0,0 +1,132 @@
+/*
+ * TofuMental - Load benchmark.
+ * Loads lists of 10 to 100k tasks from tasks.dat and from tasks.txt, through
+ * the decoders the app uses, and reports per format the file size, the load
+ * time and the heap allocations. tasks.txt is also loaded the way the app
+ * did before its one-pass parser, with wcstok() and a std::wstring per line.
+ */
+
+#include "core.h"
+#include "bench.h"
+#include <stdio.h>
+#include <wchar.h>
+
+#define RUNS 5 // Per size and format; the best is reported
+
+struct LoadCost {
+    double micros;
+    unsigned long allocs;
+};
+
+void ClearList() {
+    tasks.clear();
+    titleArena.clear();
+    nextTaskId = 1;
+}
+
+LoadCost LoadDat(const std::vector<unsigned char>& file) {
+    ClearList();
+    unsigned long allocs = benchAllocs;
+    double start = BenchMicros();
+    DecodeSnapshot(&file[0], file.size());
+    LoadCost cost = { BenchMicros() - start, benchAllocs - allocs };
+    return cost;
+}
+
+LoadCost LoadTxt(const std::vector<unsigned char>& file) {
+    ClearList();
+    unsigned long allocs = benchAllocs;
+    double start = BenchMicros();
+    titleArena.reserve(file.size() / 2 + 1); // As the app sizes it from the file
+    AppendArenaUnits(&file[0], file.size());
+    titleArena.push_back(L'\0');
+    ParseTextSnapshot(0);
+    LoadCost cost = { BenchMicros() - start, benchAllocs - allocs };
+    return cost;
+}
+
+// The loader tasks.txt had before ParseTextSnapshot, kept as the baseline.
+void LoadTxtWcstok(const std::vector<unsigned char>& file) {
+    size_t units = file.size() / 2;
+    wchar_t* buffer = new wchar_t[units + 1];
+    for (size_t i = 0; i < units; ++i) buffer[i] = (wchar_t)(file[2 * i] | (file[2 * i + 1] << 8));
+    buffer[units] = L'\0';
+    wchar_t* start = buffer;
+    if (*start == 0xFEFF) start++; // Skip BOM
+
+    size_t magicLen = wcslen(SNAPSHOT_MAGIC);
+    bool versioned = false;
+    wchar_t* state = NULL;
+    wchar_t* line = wcstok(start, L"\r\n", &state);
+    if (line && wcsncmp(line, SNAPSHOT_MAGIC, magicLen) == 0) {
+        versioned = true;
+        unsigned long storedNext = wcstoul(line + magicLen, NULL, 10);
+        if (storedNext > nextTaskId) nextTaskId = storedNext;
+        line = wcstok(NULL, L"\r\n", &state);
+    }
+    while (line) {
+        std::wstring ws(line);
+        unsigned long id = 0;
+        size_t idSep = versioned ? ws.find(L'|') : 0;
+        if (versioned && idSep != std::wstring::npos) {
+            id = wcstoul(line, NULL, 10);
+            ws.erase(0, idSep + 1);
+        }
+        size_t sep = ws.find_last_of(L'|');
+        if (sep != std::wstring::npos && idSep != std::wstring::npos) {
+            std::wstring title = ws.substr(0, sep);
+            bool completed = (ws.substr(sep + 1, 1) == L"1");
+            tasks.push_back(id ? Task(title) : MakeTask(title));
+            tasks.back().completed = completed;
+            if (id) {
+                tasks.back().id = id;
+                if (id >= nextTaskId) nextTaskId = id + 1;
+            }
+        }
+        line = wcstok(NULL, L"\r\n", &state);
+    }
+    delete[] buffer;
+}
+
+LoadCost LoadTxtBaseline(const std::vector<unsigned char>& file) {
+    ClearList();
+    unsigned long allocs = benchAllocs;
+    double start = BenchMicros();
+    LoadTxtWcstok(file);
+    LoadCost cost = { BenchMicros() - start, benchAllocs - allocs };
+    return cost;
+}
+
+LoadCost Best(LoadCost (*load)(const std::vector<unsigned char>&), const std::vector<unsigned char>& file, size_t n) {
+    LoadCost best = load(file);
+    for (int run = 1; run < RUNS; ++run) {
+        LoadCost cost = load(file);
+        if (cost.micros < best.micros) best = cost;
+    }
+    if (tasks.size() != n) printf("loaded %lu of %lu tasks\n", (unsigned long)tasks.size(), (unsigned long)n);
+    return best;
+}
+
+int main() {
+    static const size_t sizes[] = { 10, 1000, 10000, 100000 };
+    printf("%8s  %6s  %10s  %10s  %8s\n", "tasks", "format", "bytes", "load us", "allocs");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        size_t n = sizes[s];
+        BenchList(n);
+        std::vector<unsigned char> dat;
+        std::vector<unsigned char> txt;
+        EncodeSnapshot(tasks, nextTaskId, dat);
+        EncodeTextSnapshot(tasks, nextTaskId, txt);
+
+        LoadCost datCost = Best(LoadDat, dat, n);
+        LoadCost txtCost = Best(LoadTxt, txt, n);
+        LoadCost oldCost = Best(LoadTxtBaseline, txt, n);
+        printf("%8lu  %6s  %10lu  %10.0f  %8lu\n", (unsigned long)n, ".dat", (unsigned long)dat.size(), datCost.micros,
+               datCost.allocs);
+        printf("%8lu  %6s  %10lu  %10.0f  %8lu\n", (unsigned long)n, ".txt", (unsigned long)txt.size(), txtCost.micros,
+               txtCost.allocs);
+        printf("%8lu  %6s  %10lu  %10.0f  %8lu\n", (unsigned long)n, "wcstok", (unsigned long)txt.size(), oldCost.micros,
+               oldCost.allocs);
+    }
+    return 0;
+}
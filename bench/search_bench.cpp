@@ -0,0 +1,98 @@
+/*
+ * TofuMental - Search benchmark.
+ * Over 20k tasks of a few common words each, times the first BeginSearch,
+ * which builds the trigram index, then every keystroke of a set of queries:
+ * the first three, each keystroke past three (the trigram intersection and
+ * the whole-query check) and the backspaces that take the query back out.
+ * The worst keystroke is held to the 5 ms target.
+ */
+
+#include "core.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TASKS 20000
+#define TARGET_MS 5.0
+
+static const wchar_t* words[] = {
+    L"buy", L"milk", L"call", L"mom", L"meeting", L"report", L"review", L"draft", L"email", L"bank",
+    L"tax", L"return", L"book", L"dentist", L"fix", L"bike", L"plan", L"trip", L"pay", L"rent",
+    L"\xFF2D\xFF45\xFF45\xFF54", L"send", L"invoice", L"clean", L"kitchen", L"water", L"plants", L"read", L"paper",
+    L"update",
+};
+
+static const wchar_t* queries[] = {
+    L"meeting", L"review report", L"REPORT", L"e", L"invoice", L"water plants", L"nothing here", L"ing",
+};
+
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+#define QUERY_COUNT (sizeof(queries) / sizeof(queries[0]))
+
+struct KeyTimes {
+    double worst;
+    double total;
+    int count;
+};
+
+void AddTime(KeyTimes& k, double micros) {
+    if (micros > k.worst) k.worst = micros;
+    k.total += micros;
+    ++k.count;
+}
+
+void PrintTimes(const char* name, const KeyTimes& k) {
+    printf("  %-18s %5d keys, mean %8.1f us, worst %8.1f us\n", name, k.count, k.count ? k.total / k.count : 0,
+           k.worst);
+}
+
+int main() {
+    BenchList(0);
+    srand(10);
+    for (int i = 0; i < TASKS; ++i) {
+        std::wstring title;
+        int count = 2 + rand() % 4;
+        for (int w = 0; w < count; ++w) {
+            if (w) title += L' ';
+            title += words[rand() % WORD_COUNT];
+        }
+        tasks.push_back(MakeTask(title));
+    }
+
+    double start = BenchMicros();
+    BeginSearch();
+    double build = BenchMicros() - start;
+    EndSearch(false);
+    printf("%d tasks, first BeginSearch (index build) %.1f ms\n", TASKS, build / 1000);
+
+    KeyTimes early = { 0, 0, 0 };
+    KeyTimes refine = { 0, 0, 0 };
+    KeyTimes back = { 0, 0, 0 };
+    for (size_t q = 0; q < QUERY_COUNT; ++q) {
+        BeginSearch();
+        const wchar_t* query = queries[q];
+        size_t typed = 0;
+        for (; query[typed]; ++typed) {
+            start = BenchMicros();
+            EditSearchQuery(query[typed]);
+            AddTime(typed < 3 ? early : refine, BenchMicros() - start);
+        }
+        printf("  \"%ls\": %lu matches\n", query, (unsigned long)ViewSize());
+        while (typed-- > 0) {
+            start = BenchMicros();
+            EditSearchQuery(L'\b');
+            AddTime(back, BenchMicros() - start);
+        }
+        EndSearch(false);
+    }
+    PrintTimes("first 3 keys", early);
+    PrintTimes("keys past 3", refine);
+    PrintTimes("backspace", back);
+
+    double worst = early.worst;
+    if (refine.worst > worst) worst = refine.worst;
+    if (back.worst > worst) worst = back.worst;
+    printf("worst keystroke %.2f ms, %s the %.0f ms target\n", worst / 1000, worst / 1000 < TARGET_MS ? "within" : "over",
+           TARGET_MS);
+    return 0;
+}
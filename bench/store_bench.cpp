@@ -0,0 +1,101 @@
+/*
+ * TofuMental - Task store benchmark.
+ * Times TaskStore inserts and erases at random positions, and random and
+ * sequential reads, against a std::vector<Task> holding the same list, at
+ * 1k, 100k and 1M tasks, with the allocations each makes.
+ */
+
+#include "core.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define EDITS 1000    // Inserts, then as many erases
+#define READS 1000000 // Random reads; sequential reads are full passes
+#define SIZE_COUNT 3
+
+static const size_t sizes[SIZE_COUNT] = { 1000, 100000, 1000000 };
+
+volatile unsigned long readSink; // Keeps the reads from being optimized away
+
+struct StoreCost {
+    double insertNs;
+    double eraseNs;
+    double randomNs;
+    double sequentialNs;
+    double insertAllocs;
+    double eraseAllocs;
+};
+
+// The vector's edits in TaskStore's terms, so Measure can take either.
+void InsertAt(TaskStore& store, size_t pos, const Task& t) {
+    store.insert(pos, t);
+}
+
+void InsertAt(std::vector<Task>& store, size_t pos, const Task& t) {
+    store.insert(store.begin() + pos, t);
+}
+
+void EraseAt(TaskStore& store, size_t pos) {
+    store.erase(pos);
+}
+
+void EraseAt(std::vector<Task>& store, size_t pos) {
+    store.erase(store.begin() + pos);
+}
+
+template <class Store>
+StoreCost Measure(Store& store, const std::vector<size_t>& picks) {
+    StoreCost cost;
+    Task extra = store[0];
+
+    unsigned long allocs = benchAllocs;
+    double start = BenchMicros();
+    for (int i = 0; i < EDITS; ++i) InsertAt(store, picks[i] % (store.size() + 1), extra);
+    cost.insertNs = (BenchMicros() - start) * 1000 / EDITS;
+    cost.insertAllocs = (double)(benchAllocs - allocs) / EDITS;
+
+    allocs = benchAllocs;
+    start = BenchMicros();
+    for (int i = 0; i < EDITS; ++i) EraseAt(store, picks[i] % store.size());
+    cost.eraseNs = (BenchMicros() - start) * 1000 / EDITS;
+    cost.eraseAllocs = (double)(benchAllocs - allocs) / EDITS;
+
+    unsigned long sum = 0;
+    start = BenchMicros();
+    for (int i = 0; i < READS; ++i) sum += store[picks[i] % store.size()].id;
+    cost.randomNs = (BenchMicros() - start) * 1000 / READS;
+
+    size_t passes = READS / store.size() + 1;
+    start = BenchMicros();
+    for (size_t p = 0; p < passes; ++p) {
+        for (size_t i = 0; i < store.size(); ++i) sum += store[i].id;
+    }
+    cost.sequentialNs = (BenchMicros() - start) * 1000 / (passes * store.size());
+    readSink = sum;
+    return cost;
+}
+
+void PrintCost(const char* name, size_t n, const StoreCost& c) {
+    printf("%-7s %8lu %9.0f ns %9.0f ns %7.1f ns %7.1f ns %10.2f %10.2f\n", name, (unsigned long)n, c.insertNs,
+           c.eraseNs, c.randomNs, c.sequentialNs, c.insertAllocs, c.eraseAllocs);
+}
+
+int main() {
+    srand(9);
+    std::vector<size_t> picks(READS);
+    for (int i = 0; i < READS; ++i) picks[i] = ((size_t)rand() << 16) ^ (size_t)rand();
+
+    printf("%-7s %8s %12s %12s %10s %10s %10s %10s\n", "store", "tasks", "insert", "erase", "random",
+           "sequential", "allocs/ins", "allocs/era");
+    for (int s = 0; s < SIZE_COUNT; ++s) {
+        BenchList(sizes[s]);
+        std::vector<Task> plain;
+        plain.reserve(sizes[s]);
+        for (size_t i = 0; i < tasks.size(); ++i) plain.push_back(tasks[i]);
+
+        PrintCost("chunked", sizes[s], Measure(tasks, picks));
+        PrintCost("vector", sizes[s], Measure(plain, picks));
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * TofuMental - View benchmark.
+ * Builds each sorted view over 100k tasks, then times row lookups both ways
+ * and the mutations that move a task within the view, against re-sorting
+ * the list, which is what keeping a sorted copy would cost per change.
+ */
+
+#include "core.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#define TASKS 100000
+#define OPS 100000
+
+volatile long lookupSink; // Keeps the lookups from being optimized away
+
+struct SortEntry {
+    unsigned long key;
+    unsigned long id;
+};
+
+bool SortEntryLess(const SortEntry& a, const SortEntry& b) {
+    return a.key != b.key ? a.key < b.key : a.id < b.id;
+}
+
+// One re-sort of the list in the given order.
+double ResortMicros() {
+    double start = BenchMicros();
+    std::vector<SortEntry> entries(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const Task& t = tasks[i];
+        entries[i].key = viewOrder == ORDER_OPEN_FIRST ? t.completed : viewOrder == ORDER_DUE ? t.due : t.priority;
+        entries[i].id = t.id;
+    }
+    std::sort(entries.begin(), entries.end(), SortEntryLess);
+    return BenchMicros() - start;
+}
+
+int main() {
+    BenchList(TASKS);
+    srand(19);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i].priority = (unsigned char)(rand() % (PRIORITY_LEVELS + 1));
+        tasks[i].due = (unsigned short)(rand() % 2 ? 9000 + rand() % 60 : 0);
+    }
+    std::vector<int> picks(OPS);
+    for (int i = 0; i < OPS; ++i) picks[i] = rand() % TASKS;
+
+    printf("%-12s %9s %11s %11s %11s %11s %11s %9s\n", "order", "build ms", "row->task", "task->row", "toggle",
+           "priority", "re-sort", "allocs/op");
+    for (int order = ORDER_OPEN_FIRST; order < ORDER_COUNT; ++order) {
+        SetViewOrder(ORDER_LIST);
+        double start = BenchMicros();
+        SetViewOrder((ViewOrder)order);
+        ViewToTask(0);
+        double build = BenchMicros() - start;
+
+        long sum = 0;
+        start = BenchMicros();
+        for (int i = 0; i < OPS; ++i) sum += ViewToTask(picks[i]);
+        double lookup = BenchMicros() - start;
+        start = BenchMicros();
+        for (int i = 0; i < OPS; ++i) sum += TaskToView(picks[i]);
+        double reverse = BenchMicros() - start;
+
+        unsigned long allocs = benchAllocs;
+        start = BenchMicros();
+        for (int i = 0; i < OPS; ++i) ToggleTask(picks[i]);
+        double toggle = BenchMicros() - start;
+        start = BenchMicros();
+        for (int i = 0; i < OPS; ++i) SetTaskPriority(picks[i], (picks[i] + i) % (PRIORITY_LEVELS + 1));
+        double priority = BenchMicros() - start;
+        allocs = benchAllocs - allocs;
+
+        lookupSink = sum;
+
+        printf("%-12ls %9.1f %8.0f ns %8.0f ns %8.0f ns %8.0f ns %8.0f us %9.2f\n", ViewOrderName(), build / 1000,
+               lookup * 1000 / OPS, reverse * 1000 / OPS, toggle * 1000 / OPS, priority * 1000 / OPS, ResortMicros(),
+               (double)allocs / (2 * OPS));
+    }
+    return 0;
+}
@@ -3,7 +3,7 @@
 # Build script for Brain PW-SH2 Apps
 # Requires CeGCC environment
 
-SOURCE="main.cpp"
+SOURCE="main.cpp core.cpp"
 OUTPUT="./Example/AppMain.exe"
 
 # Create output directory if it doesn't exist
@@ -11,7 +11,7 @@ dirname "$OUTPUT" | xargs mkdir -p
 
 echo "Building $SOURCE for Windows CE..."
 
-arm-mingw32ce-g++ -Wall -Wextra -O3 -mcpu=arm926ej-s -static -s -o "$OUTPUT" "$SOURCE" -D_WIN32_IE=0x0400
+arm-mingw32ce-g++ -Wall -Wextra -O3 -mcpu=arm926ej-s -static -s -o "$OUTPUT" $SOURCE -D_WIN32_IE=0x0400
 
 if [ $? -eq 0 ]; then
     echo "Build successful! Output: $OUTPUT"
@@ -3,7 +3,7 @@
 # Build script for Windows 10 (Desktop)
 # Requires mingw-w64 environment (x86_64-w64-mingw32-g++)
 
-SOURCE="main.cpp"
+SOURCE="main.cpp core.cpp"
 OUTPUT_DIR="./dist_win10"
 OUTPUT="$OUTPUT_DIR/AppMain_win10.exe"
 
@@ -17,7 +17,7 @@ echo "Building App for Windows 10..."
 # -mwindows for GUI app (no console)
 # -municode for wWinMain support
 # -static for standalone executable
-x86_64-w64-mingw32-g++ -Wall -Wextra -O3 -mwindows -municode -static -s -o "$OUTPUT" "$SOURCE" -DUNICODE -D_UNICODE
+x86_64-w64-mingw32-g++ -Wall -Wextra -O3 -mwindows -municode -static -s -o "$OUTPUT" $SOURCE -DUNICODE -D_UNICODE
 
 if [ $? -eq 0 ]; then
     echo "Build successful! Output: $OUTPUT"
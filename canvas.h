@@ -0,0 +1,255 @@
+/*
+ * TofuMental - Software RGB565 canvas for the PW-SH2 panel.
+ * Plain C++ with no Win32 dependency: the window code hands it the memory of
+ * a 16bpp DIB section and draws everything but text through these kernels.
+ * Spans are written two pixels per 32-bit store; the ARM926EJ-S has no
+ * 16-bit SIMD, but a word store costs the same as a halfword store.
+ */
+
+#ifndef TOFU_CANVAS_H
+#define TOFU_CANVAS_H
+
+#include <stddef.h>
+
+typedef unsigned short Pixel565;
+typedef unsigned int PixelPair; // Two Pixel565, low half on the left
+
+// Pixel memory is written a pair at a time through this type, which may alias
+// Pixel565; a plain unsigned int* would break strict aliasing.
+#ifdef __GNUC__
+typedef unsigned int __attribute__((__may_alias__)) PixelWord;
+#else
+typedef unsigned int PixelWord;
+#endif
+
+#define RGB565(r, g, b) ((Pixel565)((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | (((b) & 0xFF) >> 3)))
+
+// Green moved to the high half so each field has headroom for a 5-bit multiply.
+#define SPREAD565_MASK 0x07E0F81Fu
+#define FADE_ONE 32 // Fade factors run from 0 (black) to FADE_ONE (unchanged)
+
+inline Pixel565 Fade565(Pixel565 p, unsigned int fade) {
+    PixelPair x = (p | ((PixelPair)p << 16)) & SPREAD565_MASK;
+    x = ((x * fade) >> 5) & SPREAD565_MASK;
+    return (Pixel565)(x | (x >> 16));
+}
+
+class Canvas565 {
+public:
+    Canvas565() : pixels(0), width(0), height(0), stride(0) { ResetClip(); }
+
+    // stride is in pixels and must be even (DIB rows are DWORD aligned).
+    void Attach(Pixel565* bits, int w, int h, int strideInPixels) {
+        pixels = bits;
+        width = w;
+        height = h;
+        stride = strideInPixels;
+        ResetClip();
+    }
+
+    void Detach() { Attach(0, 0, 0, 0); }
+    bool IsValid() const { return pixels != 0; }
+    int Width() const { return width; }
+    int Height() const { return height; }
+    Pixel565* Row(int y) const { return pixels + y * stride; }
+
+    void ResetClip() {
+        clipLeft = 0;
+        clipTop = 0;
+        clipRight = width;
+        clipBottom = height;
+    }
+
+    // Clip rect is [left, right) x [top, bottom), intersected with the canvas.
+    void SetClip(int left, int top, int right, int bottom) {
+        clipLeft = left > 0 ? left : 0;
+        clipTop = top > 0 ? top : 0;
+        clipRight = right < width ? right : width;
+        clipBottom = bottom < height ? bottom : height;
+    }
+
+    // Span [x0, x1) on row y, clipped.
+    void HLine(int x0, int x1, int y, Pixel565 c) {
+        if (y < clipTop || y >= clipBottom) return;
+        if (x0 < clipLeft) x0 = clipLeft;
+        if (x1 > clipRight) x1 = clipRight;
+        if (x0 >= x1) return;
+        FillSpan(Row(y) + x0, x1 - x0, c);
+    }
+
+    void Plot(int x, int y, Pixel565 c) {
+        if (x >= clipLeft && x < clipRight && y >= clipTop && y < clipBottom) Row(y)[x] = c;
+    }
+
+    void FillRect(int left, int top, int right, int bottom, Pixel565 c) {
+        if (top < clipTop) top = clipTop;
+        if (bottom > clipBottom) bottom = clipBottom;
+        if (left < clipLeft) left = clipLeft;
+        if (right > clipRight) right = clipRight;
+        if (left >= right) return;
+        for (int y = top; y < bottom; ++y) FillSpan(Row(y) + left, right - left, c);
+    }
+
+    // Same shape as GDI RoundRect(left, top, right, bottom, 2 * radius, 2 * radius)
+    // with a one pixel border.
+    void FillRoundRect(int left, int top, int right, int bottom, int radius, Pixel565 fill, Pixel565 border) {
+        int h = bottom - top;
+        if (h <= 0 || right <= left) return;
+        if (radius * 2 > h) radius = h / 2;
+        if (radius * 2 > right - left) radius = (right - left) / 2;
+        int insets[MAX_RADIUS + 1];
+        if (radius > MAX_RADIUS) radius = MAX_RADIUS;
+        CornerInsets(radius, insets);
+
+        for (int k = 0; k < h; ++k) {
+            int y = top + k;
+            if (y < clipTop || y >= clipBottom) continue;
+            int fromEdge = (k < h - k - 1) ? k : h - k - 1; // Rows from the nearer edge
+            int inset = (fromEdge < radius) ? insets[fromEdge] : 0;
+            if (fromEdge == 0) {
+                HLine(left + inset, right - inset, y, border);
+                continue;
+            }
+            // Border run covers the gap to the previous (outer) row's inset.
+            int prev = (fromEdge - 1 < radius) ? insets[fromEdge - 1] : 0;
+            int run = prev - inset > 1 ? prev - inset : 1;
+            HLine(left + inset, left + inset + run, y, border);
+            HLine(left + inset + run, right - inset - run, y, fill);
+            HLine(right - inset - run, right - inset, y, border);
+        }
+    }
+
+    // Circle inscribed in the square [left, right) x [top, top + right - left),
+    // matching GDI Ellipse() with a one pixel pen.
+    void FillCircle(int left, int top, int right, Pixel565 c) {
+        int d = right - left;
+        for (int k = 0; k < d; ++k) {
+            int inset = CircleInset(d, k);
+            HLine(left + inset, right - inset, top + k, c);
+        }
+    }
+
+    // One pixel ring: the circle minus the circle one pixel in from it.
+    void StrokeCircle(int left, int top, int right, Pixel565 c) {
+        int d = right - left;
+        for (int k = 0; k < d; ++k) {
+            int outer = CircleInset(d, k);
+            int inner = (k == 0 || k == d - 1 || d <= 2) ? d : 1 + CircleInset(d - 2, k - 1);
+            if (inner <= outer) inner = outer + 1;
+            if (inner * 2 >= d) {
+                HLine(left + outer, right - outer, top + k, c);
+            } else {
+                HLine(left + outer, left + inner, top + k, c);
+                HLine(right - inner, right - outer, top + k, c);
+            }
+        }
+    }
+
+    // Solid line on y with dots every `step` pixels two rows above and below.
+    void DottedSeam(int x0, int x1, int y, int step, Pixel565 line, Pixel565 dot) {
+        HLine(x0, x1, y, line);
+        bool above = (y - 2 >= clipTop && y - 2 < clipBottom);
+        bool below = (y + 2 >= clipTop && y + 2 < clipBottom);
+        if (!above && !below) return;
+        int x = x0;
+        if (x < clipLeft) x += (clipLeft - x + step - 1) / step * step;
+        int end = x1 < clipRight ? x1 : clipRight;
+        Pixel565* rowAbove = above ? Row(y - 2) : 0;
+        Pixel565* rowBelow = below ? Row(y + 2) : 0;
+        for (; x < end; x += step) {
+            if (rowAbove) rowAbove[x] = dot;
+            if (rowBelow) rowBelow[x] = dot;
+        }
+    }
+
+    // dst |= src * fade / FADE_ONE over a w x h block. Used to lay pre-rendered
+    // text on black onto the background: black source words are skipped, and a
+    // full-brightness row is a plain OR.
+    void OrBlitFaded(const Canvas565& src, int sx, int sy, int dx, int dy, int w, int h, unsigned int fade) {
+        if (dx < clipLeft) { sx += clipLeft - dx; w -= clipLeft - dx; dx = clipLeft; }
+        if (dy < clipTop) { sy += clipTop - dy; h -= clipTop - dy; dy = clipTop; }
+        if (dx + w > clipRight) w = clipRight - dx;
+        if (dy + h > clipBottom) h = clipBottom - dy;
+        if (w <= 0 || h <= 0) return;
+        if (fade > FADE_ONE) fade = FADE_ONE;
+
+        for (int k = 0; k < h; ++k) {
+            Pixel565* d = Row(dy + k) + dx;
+            const Pixel565* s = src.Row(sy + k) + sx;
+            int n = w;
+            if (((dx ^ sx) & 1) == 0) {
+                // Same word alignment on both sides: work a pair at a time.
+                if (dx & 1) {
+                    if (*s) *d |= Fade565(*s, fade);
+                    ++d; ++s; --n;
+                }
+                PixelWord* dw = (PixelWord*)d;
+                const PixelWord* sw = (const PixelWord*)s;
+                for (int pairs = n >> 1; pairs > 0; --pairs, ++dw, ++sw) {
+                    PixelPair v = *sw;
+                    if (!v) continue;
+                    if (fade < FADE_ONE) {
+                        v = Fade565((Pixel565)v, fade) | ((PixelPair)Fade565((Pixel565)(v >> 16), fade) << 16);
+                    }
+                    *dw |= v;
+                }
+                d = (Pixel565*)dw;
+                s = (const Pixel565*)sw;
+                n &= 1;
+            }
+            for (; n > 0; --n, ++d, ++s) {
+                if (*s) *d |= Fade565(*s, fade);
+            }
+        }
+    }
+
+private:
+    enum { MAX_RADIUS = 32 };
+
+    static void FillSpan(Pixel565* p, int n, Pixel565 c) {
+        if (((size_t)p & 2) && n > 0) {
+            *p++ = c;
+            --n;
+        }
+        PixelPair pair = c | ((PixelPair)c << 16);
+        PixelWord* w = (PixelWord*)p;
+        int pairs = n >> 1;
+        while (pairs >= 4) {
+            w[0] = pair; w[1] = pair; w[2] = pair; w[3] = pair;
+            w += 4;
+            pairs -= 4;
+        }
+        while (pairs-- > 0) *w++ = pair;
+        if (n & 1) *(Pixel565*)w = c;
+    }
+
+    // Pixels to skip on each side of row k of a circle of diameter d; pixel
+    // centres are tested in doubled coordinates so odd and even d both work.
+    static int CircleInset(int d, int k) {
+        int y2 = 2 * k + 1 - d;
+        int limit = d * d - y2 * y2;
+        int inset = 0;
+        while (inset * 2 < d) {
+            int x2 = 2 * inset + 1 - d;
+            if (x2 * x2 <= limit) break;
+            ++inset;
+        }
+        return inset;
+    }
+
+    static void CornerInsets(int radius, int* insets) {
+        for (int k = 0; k < radius; ++k) insets[k] = CircleInset(radius * 2, k);
+        insets[radius] = 0;
+    }
+
+    Pixel565* pixels;
+    int width;
+    int height;
+    int stride;
+    int clipLeft;
+    int clipTop;
+    int clipRight;
+    int clipBottom;
+};
+
+#endif
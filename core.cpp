@@ -0,0 +1,2058 @@
+/*
+ * TofuMental - Platform-neutral core. See core.h.
+ */
+
+#include "core.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+#include <map>
+
+// --- Task Model ---
+std::vector<wchar_t> titleArena;
+unsigned long titleRevisions = 0;
+
+TaskStore tasks;
+unsigned long nextTaskId = 1;
+int selectedIndex = 0;
+AppMode currentMode = MODE_LIST;
+
+Task MakeTask(const std::wstring& title) {
+    Task t(title);
+    t.id = nextTaskId++;
+    return t;
+}
+
+// Gregorian day count from 1970-01-01, shifted so 2000-01-01 is day 1.
+#define DAY_NUMBER_BIAS (10956L + 719468L)
+
+unsigned short DayNumber(int year, int month, int day) {
+    if (month <= 2) --year;
+    long era = year / 400;
+    long yoe = year - era * 400;
+    long doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    long n = era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - DAY_NUMBER_BIAS;
+    if (n < 1) return 0;
+    return (unsigned short)(n > 0xFFFF ? 0xFFFF : n);
+}
+
+void DayToDate(unsigned short dayNumber, int& year, int& month, int& day) {
+    long z = dayNumber + DAY_NUMBER_BIAS;
+    long era = z / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    year = (int)(yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+// --- Task Store ---
+
+TaskStore::TaskStore() : count(0), hintChunk(0), hintStart(0) {}
+
+TaskStore::TaskStore(const TaskStore& other) : count(0), hintChunk(0), hintStart(0) {
+    CopyFrom(other);
+}
+
+TaskStore& TaskStore::operator=(const TaskStore& other) {
+    if (this != &other) {
+        clear();
+        CopyFrom(other);
+    }
+    return *this;
+}
+
+TaskStore::~TaskStore() {
+    clear();
+}
+
+void TaskStore::CopyFrom(const TaskStore& other) {
+    chunks.reserve(other.chunks.size());
+    for (size_t c = 0; c < other.chunks.size(); ++c) chunks.push_back(new Chunk(*other.chunks[c]));
+    fenwick = other.fenwick;
+    count = other.count;
+    hintChunk = chunks.size();
+}
+
+void TaskStore::clear() {
+    for (size_t c = 0; c < chunks.size(); ++c) delete chunks[c];
+    chunks.clear();
+    fenwick.clear();
+    count = 0;
+    hintChunk = 0;
+    hintStart = 0;
+}
+
+void TaskStore::swap(TaskStore& other) {
+    chunks.swap(other.chunks);
+    fenwick.swap(other.fenwick);
+    size_t t = count; count = other.count; other.count = t;
+    hintChunk = chunks.size();
+    other.hintChunk = other.chunks.size();
+}
+
+void TaskStore::AddToIndex(size_t chunk, long delta) {
+    for (size_t k = chunk + 1; k <= chunks.size(); k += k & (0 - k)) fenwick[k] += delta;
+}
+
+void TaskStore::RebuildIndex() {
+    fenwick.assign(chunks.size() + 1, 0);
+    for (size_t k = 1; k <= chunks.size(); ++k) {
+        fenwick[k] += chunks[k - 1]->items.size();
+        size_t parent = k + (k & (0 - k));
+        if (parent <= chunks.size()) fenwick[parent] += fenwick[k];
+    }
+    hintChunk = chunks.size();
+}
+
+// Returns the chunk holding task i and sets offset to its position there.
+size_t TaskStore::Locate(size_t i, size_t& offset) const {
+    if (hintChunk < chunks.size()) {
+        if (i >= hintStart && i - hintStart < chunks[hintChunk]->items.size()) {
+            offset = i - hintStart;
+            return hintChunk;
+        }
+        // Next chunk: the common case of a forward scan
+        size_t nextStart = hintStart + chunks[hintChunk]->items.size();
+        if (hintChunk + 1 < chunks.size() && i >= nextStart && i - nextStart < chunks[hintChunk + 1]->items.size()) {
+            ++hintChunk;
+            hintStart = nextStart;
+            offset = i - nextStart;
+            return hintChunk;
+        }
+    }
+
+    // Descend the Fenwick tree to the last chunk whose start is <= i
+    size_t pos = 0;
+    size_t start = 0;
+    size_t step = 1;
+    while (step * 2 <= chunks.size()) step *= 2;
+    for (; step > 0; step /= 2) {
+        if (pos + step <= chunks.size() && start + fenwick[pos + step] <= i) {
+            pos += step;
+            start += fenwick[pos];
+        }
+    }
+    hintChunk = pos;
+    hintStart = start;
+    offset = i - start;
+    return pos;
+}
+
+// Position of the task with this id, or -1; ids ascend along the store.
+// Searches the chunks by their first id and then the one chunk, instead of
+// locating every probe from the top of the tree.
+int TaskStore::FindId(unsigned long id) const {
+    if (chunks.empty()) return -1;
+    size_t lo = 0;
+    size_t hi = chunks.size();
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (chunks[mid]->items[0].id <= id) lo = mid;
+        else hi = mid;
+    }
+    const std::vector<Task>& items = chunks[lo]->items;
+    size_t first = 0;
+    size_t last = items.size();
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        if (items[mid].id < id) first = mid + 1;
+        else last = mid;
+    }
+    if (first == items.size() || items[first].id != id) return -1;
+    size_t start = 0;
+    for (size_t k = lo; k > 0; k -= k & (0 - k)) start += fenwick[k];
+    // The caller nearly always reads the task next
+    hintChunk = lo;
+    hintStart = start;
+    return (int)(start + first);
+}
+
+Task& TaskStore::operator[](size_t i) {
+    size_t offset;
+    size_t c = Locate(i, offset);
+    return chunks[c]->items[offset];
+}
+
+const Task& TaskStore::operator[](size_t i) const {
+    size_t offset;
+    size_t c = Locate(i, offset);
+    return chunks[c]->items[offset];
+}
+
+void TaskStore::push_back(const Task& t) {
+    if (chunks.empty() || chunks.back()->items.size() >= TASK_CHUNK_FILL) {
+        chunks.push_back(new Chunk);
+        chunks.back()->items.reserve(TASK_CHUNK_MAX);
+        // Appending node k to a Fenwick tree: it covers chunks (k - lowbit(k), k]
+        size_t k = chunks.size();
+        size_t covered = 0;
+        for (size_t j = k - 1; j > k - (k & (0 - k)); j -= j & (0 - j)) covered += fenwick[j];
+        fenwick.resize(k + 1);
+        fenwick[k] = covered;
+        // The new chunk's index may be the "no hint" value; make it a true hint
+        hintChunk = k - 1;
+        hintStart = count;
+    }
+    chunks.back()->items.push_back(t);
+    AddToIndex(chunks.size() - 1, 1);
+    ++count;
+}
+
+void TaskStore::insert(size_t pos, const Task& t) {
+    if (pos >= count) {
+        push_back(t);
+        return;
+    }
+    size_t offset;
+    size_t c = Locate(pos, offset);
+    if (chunks[c]->items.size() >= TASK_CHUNK_MAX) {
+        // Split the full chunk in half
+        Chunk* upper = new Chunk;
+        upper->items.reserve(TASK_CHUNK_MAX);
+        std::vector<Task>& items = chunks[c]->items;
+        upper->items.assign(items.begin() + TASK_CHUNK_MAX / 2, items.end());
+        items.erase(items.begin() + TASK_CHUNK_MAX / 2, items.end());
+        chunks.insert(chunks.begin() + c + 1, upper);
+        RebuildIndex();
+        if (offset >= TASK_CHUNK_MAX / 2) {
+            offset -= TASK_CHUNK_MAX / 2;
+            ++c;
+        }
+    }
+    std::vector<Task>& items = chunks[c]->items;
+    items.insert(items.begin() + offset, t);
+    AddToIndex(c, 1);
+    ++count;
+    hintChunk = chunks.size();
+}
+
+void TaskStore::erase(size_t pos) {
+    if (pos >= count) return;
+    size_t offset;
+    size_t c = Locate(pos, offset);
+    std::vector<Task>& items = chunks[c]->items;
+    items.erase(items.begin() + offset);
+    --count;
+    hintChunk = chunks.size();
+
+    if (items.empty()) {
+        delete chunks[c];
+        chunks.erase(chunks.begin() + c);
+        RebuildIndex();
+    } else if (items.size() < TASK_CHUNK_MIN && c + 1 < chunks.size() &&
+               items.size() + chunks[c + 1]->items.size() <= TASK_CHUNK_MAX) {
+        std::vector<Task>& next = chunks[c + 1]->items;
+        items.insert(items.end(), next.begin(), next.end());
+        delete chunks[c + 1];
+        chunks.erase(chunks.begin() + c + 1);
+        RebuildIndex();
+    } else {
+        AddToIndex(c, -1);
+    }
+}
+
+// --- File Formats ---
+
+unsigned int crcTable[256];
+bool crcTableReady = false;
+
+unsigned int Crc32Update(unsigned int crc, const unsigned char* data, size_t len) {
+    if (!crcTableReady) {
+        for (unsigned int n = 0; n < 256; ++n) {
+            unsigned int c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crcTable[n] = c;
+        }
+        crcTableReady = true;
+    }
+    for (size_t i = 0; i < len; ++i) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+unsigned int Crc32(const unsigned char* data, size_t len) {
+    return Crc32Update(CRC32_INIT, data, len) ^ CRC32_INIT;
+}
+
+unsigned int JournalChecksum(const unsigned char* data, size_t len) {
+    unsigned int h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Where wchar_t is UTF-16 (every Windows build) units are copied as they
+// are; elsewhere they are widened or narrowed one at a time.
+void AppendArenaUnits(const unsigned char* data, size_t bytes) {
+    size_t at = titleArena.size();
+    size_t n = bytes / 2;
+    if (n == 0) return;
+    titleArena.resize(at + n);
+    if (sizeof(wchar_t) == 2) {
+        memcpy(&titleArena[at], data, n * 2);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) titleArena[at + i] = (wchar_t)(data[2 * i] | (data[2 * i + 1] << 8));
+}
+
+void PutTitleUnits(unsigned char* out, const wchar_t* s, size_t len) {
+    if (sizeof(wchar_t) == 2) {
+        memcpy(out, s, len * 2);
+        return;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        out[2 * i] = (unsigned char)s[i];
+        out[2 * i + 1] = (unsigned char)(s[i] >> 8);
+    }
+}
+
+TaskTitle AppendArenaTitle(const unsigned char* units, size_t len) {
+    size_t offset = titleArena.size();
+    AppendArenaUnits(units, len * 2);
+    titleArena.push_back(L'\0');
+    return TaskTitle::FromArena(offset, len);
+}
+
+void EncodeJournalRecord(unsigned char op, const Task& t, std::vector<unsigned char>& out) {
+    JournalRecord rec;
+    rec.id = (unsigned int)t.id;
+    rec.op = op;
+    rec.completed = t.completed ? 1 : 0;
+    rec.titleLen = 0;
+    const wchar_t* title = t.title.c_str();
+    wchar_t due = (wchar_t)t.due;
+    if (op == JOP_ADD || op == JOP_SET_TITLE) {
+        rec.titleLen = (unsigned short)(t.title.size() > 0xFFFF ? 0xFFFF : t.title.size());
+    } else if (op == JOP_SET_PLAN) {
+        rec.completed = t.priority;
+        rec.titleLen = 1;
+        title = &due;
+    }
+
+    size_t bodyBytes = sizeof(rec) + rec.titleLen * 2;
+    size_t at = out.size();
+    out.resize(at + bodyBytes + sizeof(unsigned int));
+    unsigned char* buf = &out[at];
+    memcpy(buf, &rec, sizeof(rec));
+    PutTitleUnits(buf + sizeof(rec), title, rec.titleLen);
+    unsigned int sum = JournalChecksum(buf, bodyBytes);
+    memcpy(buf + bodyBytes, &sum, sizeof(sum));
+
+    // Adds (new, undone, archived or synced) keep their record format; a plan
+    // follows in its own record
+    if (op == JOP_ADD && (t.priority || t.due)) EncodeJournalRecord(JOP_SET_PLAN, t, out);
+}
+
+// Deleted tasks are tombstoned (id 0) during replay and swept once at the end.
+void ApplyJournalRecord(const JournalRecord& rec, const unsigned char* title, std::map<unsigned long, size_t>& index) {
+    std::map<unsigned long, size_t>::iterator it = index.find(rec.id);
+    switch (rec.op) {
+        case JOP_ADD:
+            if (it == index.end()) {
+                tasks.push_back(Task());
+                tasks.back().title = AppendArenaTitle(title, rec.titleLen);
+                tasks.back().completed = rec.completed != 0;
+                tasks.back().id = rec.id;
+                index[rec.id] = tasks.size() - 1;
+            }
+            break;
+        case JOP_DELETE:
+            if (it != index.end()) {
+                tasks[it->second].id = 0;
+                index.erase(it);
+            }
+            break;
+        case JOP_SET_COMPLETED:
+            if (it != index.end()) tasks[it->second].completed = rec.completed != 0;
+            break;
+        case JOP_SET_TITLE:
+            if (it != index.end()) tasks[it->second].title = AppendArenaTitle(title, rec.titleLen);
+            break;
+        case JOP_SET_PLAN:
+            if (it != index.end()) {
+                tasks[it->second].priority = rec.completed;
+                tasks[it->second].due = rec.titleLen ? (unsigned short)(title[0] | (title[1] << 8)) : 0;
+            }
+            break;
+    }
+    if (rec.id >= nextTaskId) nextTaskId = rec.id + 1;
+}
+
+size_t ReplayJournalRecords(const unsigned char* data, size_t size, std::map<unsigned long, size_t>& index) {
+    size_t pos = 0;
+    while (size - pos >= sizeof(JournalRecord)) {
+        JournalRecord rec;
+        memcpy(&rec, data + pos, sizeof(rec));
+        size_t bodyBytes = sizeof(rec) + rec.titleLen * 2;
+        if (size - pos < bodyBytes + sizeof(unsigned int)) break;
+        unsigned int sum;
+        memcpy(&sum, data + pos + bodyBytes, sizeof(sum));
+        if (sum != JournalChecksum(data + pos, bodyBytes)) break;
+        ApplyJournalRecord(rec, data + pos + sizeof(rec), index);
+        pos += bodyBytes + sizeof(unsigned int);
+    }
+    return pos;
+}
+
+void EncodeSnapshot(const TaskStore& list, unsigned long nextId, std::vector<unsigned char>& out) {
+    size_t heapChars = 0;
+    for (size_t i = 0; i < list.size(); ++i) {
+        size_t len = list[i].title.size();
+        heapChars += (len > 0xFFFF ? 0xFFFF : len) + 1;
+    }
+    size_t recordBytes = list.size() * sizeof(SnapshotRecord);
+    size_t heapAt = sizeof(SnapshotHeader) + recordBytes;
+    out.assign(heapAt + heapChars * 2, 0);
+
+    size_t heapPos = 0;
+    for (size_t i = 0; i < list.size(); ++i) {
+        const Task& t = list[i];
+        SnapshotRecord rec;
+        rec.id = (unsigned int)t.id;
+        rec.titleOffset = (unsigned int)heapPos;
+        rec.titleLen = (unsigned short)(t.title.size() > 0xFFFF ? 0xFFFF : t.title.size());
+        rec.flags = t.completed ? SNAPSHOT_COMPLETED : 0;
+        rec.due = t.due;
+        rec.priority = t.priority;
+        rec.reserved = 0;
+        memcpy(&out[sizeof(SnapshotHeader) + i * sizeof(rec)], &rec, sizeof(rec));
+        PutTitleUnits(&out[heapAt + heapPos * 2], t.title.c_str(), rec.titleLen); // The NUL is already there
+        heapPos += rec.titleLen + 1;
+    }
+
+    SnapshotHeader header;
+    header.magic = SNAPSHOT_FILE_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.nextId = (unsigned int)nextId;
+    header.count = (unsigned int)list.size();
+    header.heapChars = (unsigned int)heapChars;
+    header.crc = Crc32(&out[sizeof(header)], out.size() - sizeof(header));
+    memcpy(&out[0], &header, sizeof(header));
+}
+
+size_t CheckSnapshotHeader(const SnapshotHeader& header, size_t fileSize) {
+    size_t recordBytes = header.version == 3 ? SNAPSHOT_V3_RECORD_BYTES : sizeof(SnapshotRecord);
+    bool ok = fileSize >= sizeof(header) && fileSize % 2 == 0 && header.magic == SNAPSHOT_FILE_MAGIC &&
+              (header.version == SNAPSHOT_VERSION || header.version == 3) && header.headerSize == sizeof(header) &&
+              header.count <= fileSize / recordBytes && header.heapChars <= fileSize / 2 &&
+              fileSize == sizeof(header) + header.count * recordBytes + header.heapChars * 2;
+    return ok ? recordBytes : 0;
+}
+
+SnapshotRecord GetSnapshotRecord(const unsigned char* records, size_t recordBytes, size_t i) {
+    SnapshotRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    memcpy(&rec, records + i * recordBytes, recordBytes);
+    return rec;
+}
+
+// The records are checked and turned into tasks without parsing.
+void BuildSnapshotTasks(const SnapshotHeader& header, const unsigned char* records, size_t recordBytes,
+                        size_t from, size_t to, size_t heapStart, TaskStore& out) {
+    for (size_t i = from; i < to; ++i) {
+        SnapshotRecord rec;
+        if (recordBytes == sizeof(rec)) memcpy(&rec, records + i * sizeof(rec), sizeof(rec));
+        else rec = GetSnapshotRecord(records, recordBytes, i);
+        if (rec.titleOffset >= header.heapChars || header.heapChars - rec.titleOffset <= rec.titleLen) continue;
+        out.push_back(Task());
+        Task& t = out.back();
+        t.title = TaskTitle::FromArena(heapStart + rec.titleOffset, rec.titleLen);
+        t.completed = (rec.flags & SNAPSHOT_COMPLETED) != 0;
+        t.priority = rec.priority;
+        t.due = rec.due;
+        t.id = rec.id;
+        if (t.id >= nextTaskId) nextTaskId = t.id + 1;
+    }
+}
+
+void PreviewHeapRange(const unsigned char* records, size_t recordBytes, size_t count, size_t& lo, size_t& hi) {
+    lo = hi = 0;
+    if (count == 0) return;
+    SnapshotRecord first = GetSnapshotRecord(records, recordBytes, 0);
+    SnapshotRecord last = GetSnapshotRecord(records, recordBytes, count - 1);
+    if (last.titleOffset < first.titleOffset) return;
+    lo = first.titleOffset;
+    hi = (size_t)last.titleOffset + last.titleLen + 1;
+}
+
+void AppendPreviewTasks(const unsigned char* records, size_t recordBytes, size_t count,
+                        const unsigned char* heap, size_t lo, size_t hi) {
+    for (size_t i = 0; i < count; ++i) {
+        SnapshotRecord rec = GetSnapshotRecord(records, recordBytes, i);
+        if (rec.titleOffset < lo || rec.titleOffset + rec.titleLen >= hi) continue;
+        const unsigned char* units = heap + (rec.titleOffset - lo) * 2;
+        std::wstring title(rec.titleLen, L'\0');
+        for (size_t k = 0; k < rec.titleLen; ++k) title[k] = (wchar_t)(units[2 * k] | (units[2 * k + 1] << 8));
+        tasks.push_back(Task(title));
+        tasks.back().completed = (rec.flags & SNAPSHOT_COMPLETED) != 0;
+        tasks.back().priority = rec.priority;
+        tasks.back().due = rec.due;
+        tasks.back().id = rec.id;
+    }
+}
+
+// Appends records [first, first + count) with their titles copied out.
+void PreviewRecords(const SnapshotHeader& header, size_t recordBytes, size_t first, size_t count,
+                    SnapshotReader& reader) {
+    if (count == 0) return;
+    std::vector<unsigned char> records(count * recordBytes);
+    if (!reader.ReadAt(sizeof(header) + first * recordBytes, &records[0], records.size())) return;
+    size_t lo, hi;
+    PreviewHeapRange(&records[0], recordBytes, count, lo, hi);
+    if (hi <= lo || hi > header.heapChars) return;
+    std::vector<unsigned char> heap((hi - lo) * 2);
+    size_t heapStart = sizeof(header) + header.count * recordBytes;
+    if (!reader.ReadAt(heapStart + lo * 2, &heap[0], heap.size())) return;
+    AppendPreviewTasks(&records[0], recordBytes, count, &heap[0], lo, hi);
+}
+
+void LoadSnapshotPreview(const SnapshotHeader& header, size_t recordBytes, SnapshotReader& reader) {
+    size_t n = header.count;
+    if (n <= 2 * LOAD_PREVIEW_ROWS) {
+        PreviewRecords(header, recordBytes, 0, n, reader);
+    } else {
+        PreviewRecords(header, recordBytes, 0, LOAD_PREVIEW_ROWS, reader);
+        PreviewRecords(header, recordBytes, n - LOAD_PREVIEW_ROWS, LOAD_PREVIEW_ROWS, reader);
+    }
+}
+
+bool DecodeSnapshot(const unsigned char* data, size_t size) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    size_t recordBytes = CheckSnapshotHeader(header, size);
+    if (!recordBytes || Crc32(data + sizeof(header), size - sizeof(header)) != header.crc) return false;
+    size_t heapStart = titleArena.size() + (sizeof(header) + header.count * recordBytes) / 2;
+    AppendArenaUnits(data, size);
+    BuildSnapshotTasks(header, data + sizeof(header), recordBytes, 0, header.count, heapStart, tasks);
+    if (header.nextId > nextTaskId) nextTaskId = header.nextId;
+    return true;
+}
+
+void AppendTextUnits(std::vector<unsigned char>& out, const wchar_t* s, size_t len) {
+    size_t at = out.size();
+    out.resize(at + len * 2);
+    PutTitleUnits(&out[at], s, len);
+}
+
+// Without swprintf, whose arguments differ between the CE runtime and C99.
+void AppendTextNumber(std::vector<unsigned char>& out, unsigned long n) {
+    wchar_t digits[16];
+    size_t len = 0;
+    do {
+        digits[15 - len++] = (wchar_t)(L'0' + n % 10);
+        n /= 10;
+    } while (n);
+    AppendTextUnits(out, digits + 16 - len, len);
+}
+
+void EncodeTextSnapshot(const TaskStore& list, unsigned long nextId, std::vector<unsigned char>& out) {
+    const wchar_t bom = 0xFEFF;
+    out.clear();
+    AppendTextUnits(out, &bom, 1);
+    AppendTextUnits(out, SNAPSHOT_MAGIC, wcslen(SNAPSHOT_MAGIC));
+    AppendTextUnits(out, L" ", 1);
+    AppendTextNumber(out, nextId);
+    AppendTextUnits(out, L"\r\n", 2);
+    for (size_t i = 0; i < list.size(); ++i) {
+        const Task& t = list[i];
+        AppendTextNumber(out, t.id);
+        AppendTextUnits(out, L"|", 1);
+        AppendTextUnits(out, t.title.c_str(), t.title.size());
+        AppendTextUnits(out, t.completed ? L"|1\r\n" : L"|0\r\n", 4);
+    }
+}
+
+// Reads both the versioned "id|title|flag" format and legacy "title|flag"
+// files in one pass over the buffer, with the same rules the old wcstok()
+// loop had: CR and LF both end a line, empty lines and lines without '|' are
+// skipped, the last '|' separates the flag, and an embedded NUL ends the file.
+void ParseTextSnapshot(size_t start) {
+    wchar_t* buf = &titleArena[0];
+    size_t pos = (buf[start] == 0xFEFF) ? start + 1 : start; // Skip BOM
+    size_t magicLen = wcslen(SNAPSHOT_MAGIC);
+    bool firstLine = true;
+    bool versioned = false;
+    while (buf[pos]) {
+        if (buf[pos] == L'\r' || buf[pos] == L'\n') {
+            ++pos;
+            continue;
+        }
+
+        size_t lineStart = pos;
+        size_t firstSep = std::wstring::npos;
+        size_t lastSep = std::wstring::npos;
+        for (; buf[pos] && buf[pos] != L'\r' && buf[pos] != L'\n'; ++pos) {
+            if (buf[pos] == L'|') {
+                if (firstSep == std::wstring::npos) firstSep = pos;
+                lastSep = pos;
+            }
+        }
+
+        if (firstLine) {
+            firstLine = false;
+            if (pos - lineStart >= magicLen && wcsncmp(buf + lineStart, SNAPSHOT_MAGIC, magicLen) == 0) {
+                versioned = true;
+                unsigned long storedNext = wcstoul(buf + lineStart + magicLen, NULL, 10);
+                if (storedNext > nextTaskId) nextTaskId = storedNext;
+                continue;
+            }
+        }
+
+        size_t titleStart = lineStart;
+        unsigned long id = 0;
+        if (versioned) {
+            if (firstSep == lastSep) continue; // Needs both the id and flag separators
+            id = wcstoul(buf + lineStart, NULL, 10);
+            titleStart = firstSep + 1;
+        } else if (lastSep == std::wstring::npos) {
+            continue;
+        }
+
+        bool completed = (buf[lastSep + 1] == L'1');
+        buf[lastSep] = L'\0';
+        tasks.push_back(Task());
+        Task& t = tasks.back();
+        t.title = TaskTitle::FromArena(titleStart, lastSep - titleStart);
+        t.completed = completed;
+        t.id = id ? id : nextTaskId;
+        if (t.id >= nextTaskId) nextTaskId = t.id + 1;
+    }
+}
+
+// --- Scroll Animation ---
+// Each retarget adds an impulse: the distance the target moved, eased out
+// over ANIM_DURATION from the moment it was added. The wheel is drawn at
+// target minus the part of every impulse not yet covered, so a new target
+// never restarts or disturbs motion already in flight. Retargets made in the
+// same tick, such as a burst of queued key repeats, share one impulse.
+
+#define EASE_SHIFT 16
+#define MAX_SCROLL_IMPULSES 16
+
+struct ScrollImpulse {
+    long delta; // 24.8 rows
+    unsigned long startTime;
+    unsigned long duration;
+};
+
+long visualScrollPos = 0;
+long targetScrollPos = 0;
+bool isAnimating = false;
+
+ScrollImpulse scrollImpulses[MAX_SCROLL_IMPULSES];
+int scrollImpulseCount = 0;
+
+// The part of an impulse not yet covered, (1 - t)^3 in 0.16 fixed point,
+// rounded. 1 - t is taken to 20 bits so that even a jump across a long list
+// lands within a pixel of the exact curve; a table would need hundreds of
+// entries for that.
+long EaseRemaining(unsigned long elapsed, unsigned long duration) {
+    if (elapsed >= duration) return 0;
+    unsigned long long u = ((unsigned long long)(duration - elapsed) << 20) / duration;
+    return (long)((u * u * u + (1ULL << 43)) >> 44);
+}
+
+// Summed before the one rounding shift, so the error does not grow with the
+// number of impulses in flight.
+long GetScrollPosition(unsigned long now) {
+    long long behind = 0;
+    for (int k = 0; k < scrollImpulseCount; ++k) {
+        behind += (long long)scrollImpulses[k].delta * EaseRemaining(now - scrollImpulses[k].startTime, scrollImpulses[k].duration);
+    }
+    return targetScrollPos - (long)((behind + (1 << (EASE_SHIFT - 1))) >> EASE_SHIFT);
+}
+
+// Drops impulses that have fully played out; returns true while any remain.
+bool AdvanceScrollImpulses(unsigned long now) {
+    int live = 0;
+    for (int k = 0; k < scrollImpulseCount; ++k) {
+        if (now - scrollImpulses[k].startTime < scrollImpulses[k].duration) scrollImpulses[live++] = scrollImpulses[k];
+    }
+    scrollImpulseCount = live;
+    return live > 0;
+}
+
+// Wraps the target into [0, n). Every drawn quantity is periodic in n, so
+// shifting target and visual position by whole laps changes nothing on screen.
+void NormalizeScroll() {
+    long lap = INT_TO_FIX(ViewSize());
+    if (lap == 0) return;
+    long shift = 0;
+    while (targetScrollPos + shift < 0) shift += lap;
+    while (targetScrollPos + shift >= lap) shift -= lap;
+    targetScrollPos += shift;
+    visualScrollPos += shift;
+}
+
+void SetScrollTarget(long target, unsigned long now, unsigned long duration) {
+    long delta = target - targetScrollPos;
+    if (delta == 0) return;
+    targetScrollPos = target;
+    ScrollImpulse* last = scrollImpulseCount > 0 ? &scrollImpulses[scrollImpulseCount - 1] : 0;
+    if (last && last->startTime == now && last->duration == duration) {
+        // Nothing of it is covered yet, so growing it keeps the position continuous
+        last->delta += delta;
+        NormalizeScroll();
+        return;
+    }
+    if (scrollImpulseCount == MAX_SCROLL_IMPULSES) {
+        // Fold the oldest impulse's remaining distance into the new one, which
+        // starts now with nothing covered, so the position stays continuous.
+        long remaining = EaseRemaining(now - scrollImpulses[0].startTime, scrollImpulses[0].duration);
+        delta += (long)(((long long)scrollImpulses[0].delta * remaining) >> EASE_SHIFT);
+        for (int k = 1; k < scrollImpulseCount; ++k) scrollImpulses[k - 1] = scrollImpulses[k];
+        --scrollImpulseCount;
+    }
+    scrollImpulses[scrollImpulseCount].delta = delta;
+    scrollImpulses[scrollImpulseCount].startTime = now;
+    scrollImpulses[scrollImpulseCount].duration = duration;
+    ++scrollImpulseCount;
+    NormalizeScroll();
+}
+
+// Jumps to a row with no animation.
+void SnapScroll(int row) {
+    scrollImpulseCount = 0;
+    visualScrollPos = targetScrollPos = INT_TO_FIX(row);
+}
+
+// Animates to an unwrapped row index (it may lie outside [0, n) to keep a lap).
+void ScrollTowardRow(int row, unsigned long now) {
+    SetScrollTarget(INT_TO_FIX(row), now, ANIM_DURATION);
+    isAnimating = true;
+}
+
+void ScrollTowardIndex(int index, unsigned long now) {
+    if (ViewSize() == 0) return;
+
+    // Shortest path logic for infinite loop
+    int n = (int)ViewSize();
+    int fromRow = FIX_FLOOR(targetScrollPos);
+    int diff = index - fromRow;
+    if (diff * 2 > n) diff -= n;
+    else if (diff * 2 < -n) diff += n;
+
+    ScrollTowardRow(fromRow + diff, now);
+}
+
+// Moves the wheel to `now`; returns false once it has settled.
+bool TickScroll(unsigned long now) {
+    if (!isAnimating) return false;
+    if (!AdvanceScrollImpulses(now)) {
+        isAnimating = false;
+        visualScrollPos = targetScrollPos;
+        // Ensure selectedIndex matches
+        if (ViewSize() > 0) selectedIndex = FIX_FLOOR(targetScrollPos) % (int)ViewSize();
+        return false;
+    }
+    visualScrollPos = GetScrollPosition(now);
+    return true;
+}
+
+// --- Drag & Flick ---
+// While dragged the wheel follows the stylus one-to-one and the target moves
+// with it. On release it coasts from the stylus speed under FLICK_DECEL to
+// the nearest whole row of where that would stop. The coast is an impulse
+// whose length is chosen so the ease-out curve starts at the release speed.
+
+bool dragging = false;
+int dragAnchorY = 0;
+long dragAnchorPos = 0;
+int dragLastY = 0;
+unsigned long dragLastTime = 0;
+long dragVelocity = 0; // 24.8 rows per second
+bool dragMoved = false;
+
+bool IsDragging() {
+    return dragging;
+}
+
+void BeginDrag(int y, unsigned long now) {
+    if (ViewSize() == 0) return;
+    // Catch the wheel where it is
+    visualScrollPos = GetScrollPosition(now);
+    targetScrollPos = visualScrollPos;
+    scrollImpulseCount = 0;
+    isAnimating = false;
+    dragging = true;
+    dragMoved = false;
+    dragAnchorY = dragLastY = y;
+    dragAnchorPos = visualScrollPos;
+    dragLastTime = now;
+    dragVelocity = 0;
+}
+
+bool DragTo(int y, unsigned long now) {
+    if (!dragging) return false;
+    if (!dragMoved && abs(y - dragAnchorY) < DRAG_SLOP) return false;
+    dragMoved = true;
+    // Stylus down pulls earlier rows into view
+    long pos = dragAnchorPos - (long)(y - dragAnchorY) * FIX_ONE / ROW_SPACING;
+    unsigned long dt = now - dragLastTime;
+    if (dt > 0 && y != dragLastY) { // Sideways moves are not samples
+        long step = -(long)(y - dragLastY) * FIX_ONE / ROW_SPACING;
+        long sample = (long)((long long)step * 1000 / (long)dt);
+        dragVelocity = (dragVelocity + sample) / 2;
+        dragLastY = y;
+        dragLastTime = now;
+    }
+    visualScrollPos = targetScrollPos = pos;
+    return true;
+}
+
+bool EndDrag(int y, unsigned long now) {
+    if (!dragging) return false;
+    bool held = now - dragLastTime > FLICK_HOLD_MS; // Still before lifting; DragTo restarts the clock
+    DragTo(y, now);
+    dragging = false;
+    if (!dragMoved) {
+        // A tap: let a wheel caught between rows settle
+        SetScrollTarget(INT_TO_FIX(FIX_ROUND(visualScrollPos)), now, ANIM_DURATION);
+        NormalizeScroll();
+        isAnimating = true;
+        return false;
+    }
+
+    long velocity = held ? 0 : dragVelocity;
+    long from = visualScrollPos;
+    long coast = 0;
+    if (abs(velocity) >= INT_TO_FIX(FLICK_MIN_SPEED)) {
+        coast = (long)((long long)velocity * abs(velocity) / (2 * FLICK_DECEL * FIX_ONE));
+    }
+    long land = INT_TO_FIX(FIX_ROUND(from + coast));
+    unsigned long duration = ANIM_DURATION;
+    long distance = land - from;
+    if (coast != 0 && (distance > 0) == (velocity > 0) && distance != 0) {
+        // Ease-out cubic starts at 3 * distance / duration
+        duration = (unsigned long)((long long)3 * 1000 * distance / velocity);
+        if (duration < (unsigned long)ANIM_DURATION) duration = ANIM_DURATION;
+        if (duration > FLICK_MAX_MS) duration = FLICK_MAX_MS;
+    }
+    SetScrollTarget(land, now, duration);
+    NormalizeScroll(); // Also when released exactly on a row
+    isAnimating = true;
+    selectedIndex = WrapIndex(FIX_FLOOR(targetScrollPos), (int)ViewSize());
+    return true;
+}
+
+// --- Input ---
+
+int WrapIndex(int j, int n) {
+    return (j % n + n) % n;
+}
+
+bool StepSelection(int delta) {
+    if (ViewSize() == 0) return false;
+    selectedIndex = WrapIndex(selectedIndex + delta, (int)ViewSize());
+    return true;
+}
+
+void RecordEdit(EditKind kind, int index);
+
+bool ToggleTask(int index) {
+    if (index < 0 || index >= (int)tasks.size()) return false;
+    UnviewTask(tasks[index]);
+    tasks[index].completed = !tasks[index].completed;
+    ViewTask(tasks[index]);
+    RecordEdit(EDIT_TOGGLE, index);
+    return true;
+}
+
+bool EraseTask(int index) {
+    if (index < 0 || index >= (int)tasks.size()) return false;
+    RecordEdit(EDIT_DELETE, index);
+    UnindexTask(tasks[index]);
+    UnviewTask(tasks[index]);
+    tasks.erase(index);
+    if (selectedIndex >= (int)tasks.size()) selectedIndex = (int)tasks.size() - 1;
+    if (selectedIndex < 0) selectedIndex = 0; // Handle case where all tasks are deleted
+    SnapScroll(selectedIndex);
+    return true;
+}
+
+// The new task is journaled once its title is committed. It is always the
+// last task; the wheel shows it wherever the view order puts it.
+void BeginAddTask() {
+    tasks.push_back(MakeTask(L""));
+    ViewTask(tasks.back());
+    currentMode = MODE_ADD;
+    selectedIndex = TaskToView((int)tasks.size() - 1);
+    SnapScroll(selectedIndex); // Snap for add
+}
+
+// Backspace (L'\b') or a printable character.
+bool EditSelectedTitle(wchar_t ch) {
+    if (ch == L'\b') {
+        std::wstring& title = tasks[tasks.size() - 1].title.Edit();
+        if (!title.empty()) {
+            title.erase(title.size() - 1);
+        }
+        return true;
+    }
+    if (ch >= 32) {
+        tasks[tasks.size() - 1].title.Edit() += ch;
+        return true;
+    }
+    return false;
+}
+
+// Enter: keeps the new task whatever its title.
+void CommitAddTask() {
+    currentMode = MODE_LIST;
+    IndexTask(tasks[tasks.size() - 1]);
+    RecordEdit(EDIT_ADD, (int)tasks.size() - 1);
+}
+
+// Escape: leaves add mode, dropping the new task if it is still untitled.
+// Returns true if the task was kept.
+bool EndAddTask() {
+    currentMode = MODE_LIST;
+    int last = (int)tasks.size() - 1;
+    bool kept = !tasks[last].title.empty();
+    if (!kept) {
+        UnviewTask(tasks[last]);
+        tasks.erase(last);
+        if (selectedIndex >= (int)tasks.size()) selectedIndex = (int)tasks.size() - 1;
+        if (selectedIndex < 0) selectedIndex = 0;
+    } else {
+        IndexTask(tasks[last]);
+        RecordEdit(EDIT_ADD, last);
+    }
+    SnapScroll(selectedIndex);
+    return kept;
+}
+
+// Row slots away from the focus frame, rounded to the nearest.
+int TapSlot(int y, int height) {
+    int dy = y - height / 2;
+    return (dy >= 0) ? (dy + ROW_SPACING / 2) / ROW_SPACING : (dy - ROW_SPACING / 2) / ROW_SPACING;
+}
+
+bool TapHitsIndicator(int x) {
+    return x >= MARGIN_X && x < MARGIN_X + TEXT_INDENT;
+}
+
+// Unwrapped row drawn `slot` positions from the focus frame (including lap).
+int SlotToRow(int slot) {
+    return FIX_ROUND(visualScrollPos) + slot;
+}
+
+// --- Undo ---
+// Each entry is an UndoEntry header, the title for adds and deletes, then the
+// title length again so the log can be walked backwards. Entries in
+// [undoStart, undoCursor) can be undone and those after undoCursor redone.
+// Evicted entries are skipped over by undoStart and only moved out of the
+// buffer once they make up half of it.
+
+struct UndoEntry {
+    unsigned long id;
+    unsigned long position;
+    unsigned short titleLen;
+    unsigned char kind;
+    unsigned char completed;
+    unsigned char priority;
+    unsigned short due;
+};
+
+std::vector<unsigned char> undoLog;
+size_t undoStart = 0;
+size_t undoCursor = 0;
+
+size_t UndoEntrySize(unsigned short titleLen) {
+    return sizeof(UndoEntry) + titleLen * sizeof(wchar_t) + sizeof(unsigned short);
+}
+
+void ResetUndo() {
+    undoLog.clear();
+    undoStart = 0;
+    undoCursor = 0;
+}
+
+bool CanUndo() {
+    return undoCursor > undoStart;
+}
+
+bool CanRedo() {
+    return undoCursor < undoLog.size();
+}
+
+void RecordEdit(EditKind kind, int index) {
+    const Task& t = tasks[index];
+    UndoEntry e;
+    e.id = t.id;
+    e.position = (unsigned long)index;
+    e.titleLen = 0;
+    e.kind = (unsigned char)kind;
+    e.completed = t.completed ? 1 : 0;
+    e.priority = t.priority;
+    e.due = t.due;
+    size_t titleLen = kind == EDIT_TOGGLE ? 0 : t.title.size();
+    if (titleLen <= 0xFFFF) e.titleLen = (unsigned short)titleLen;
+
+    // A new edit ends the redo branch
+    undoLog.resize(undoCursor);
+    size_t bytes = UndoEntrySize(e.titleLen);
+    if (titleLen > 0xFFFF || bytes > UNDO_LOG_BYTES) {
+        // Older entries would replay against the wrong list without this one,
+        // which cannot be kept whole
+        ResetUndo();
+        return;
+    }
+    while (undoLog.size() - undoStart + bytes > UNDO_LOG_BYTES) {
+        UndoEntry oldest;
+        memcpy(&oldest, &undoLog[undoStart], sizeof(oldest));
+        undoStart += UndoEntrySize(oldest.titleLen);
+    }
+    if (undoStart > UNDO_LOG_BYTES / 2) {
+        undoLog.erase(undoLog.begin(), undoLog.begin() + undoStart);
+        undoStart = 0;
+    }
+
+    size_t at = undoLog.size();
+    undoLog.resize(at + bytes);
+    memcpy(&undoLog[at], &e, sizeof(e));
+    if (e.titleLen) memcpy(&undoLog[at + sizeof(e)], t.title.c_str(), e.titleLen * sizeof(wchar_t));
+    memcpy(&undoLog[at + bytes - sizeof(unsigned short)], &e.titleLen, sizeof(unsigned short));
+    undoCursor = undoLog.size();
+}
+
+int FindTaskIndex(unsigned long id);
+
+// Applies `kind` to the list as described by the entry at `at`.
+void ApplyEdit(EditKind kind, size_t at, Task& task) {
+    UndoEntry e;
+    memcpy(&e, &undoLog[at], sizeof(e));
+    int index = (int)e.position;
+    if (index > (int)tasks.size()) index = (int)tasks.size();
+    int row;
+
+    if (kind == EDIT_ADD) {
+        // Titles sit at any byte offset in the log
+        std::wstring title(e.titleLen, L'\0');
+        if (e.titleLen) memcpy(&title[0], &undoLog[at + sizeof(e)], e.titleLen * sizeof(wchar_t));
+        task = Task(title);
+        task.id = e.id;
+        task.completed = e.completed != 0;
+        task.priority = e.priority;
+        task.due = e.due;
+        tasks.insert(index, task);
+        IndexTask(task);
+        ViewTask(task);
+        row = TaskToView(index);
+    } else {
+        if (index >= (int)tasks.size() || tasks[index].id != e.id) index = FindTaskIndex(e.id);
+        if (index < 0) return;
+        if (kind == EDIT_TOGGLE) {
+            UnviewTask(tasks[index]);
+            tasks[index].completed = !tasks[index].completed;
+            ViewTask(tasks[index]);
+            task = tasks[index];
+            row = TaskToView(index);
+        } else {
+            task = tasks[index];
+            row = TaskToView(index);
+            UnindexTask(task);
+            UnviewTask(task);
+            tasks.erase(index);
+            if (row >= (int)tasks.size()) row = (int)tasks.size() - 1;
+        }
+    }
+    selectedIndex = row < 0 ? 0 : row;
+    SnapScroll(selectedIndex);
+}
+
+EditKind InverseEdit(EditKind kind) {
+    if (kind == EDIT_ADD) return EDIT_DELETE;
+    if (kind == EDIT_DELETE) return EDIT_ADD;
+    return EDIT_TOGGLE;
+}
+
+bool Undo(EditKind& applied, Task& task) {
+    if (!CanUndo()) return false;
+    unsigned short titleLen;
+    memcpy(&titleLen, &undoLog[undoCursor - sizeof(titleLen)], sizeof(titleLen));
+    undoCursor -= UndoEntrySize(titleLen);
+    UndoEntry e;
+    memcpy(&e, &undoLog[undoCursor], sizeof(e));
+    applied = InverseEdit((EditKind)e.kind);
+    ApplyEdit(applied, undoCursor, task);
+    return true;
+}
+
+bool Redo(EditKind& applied, Task& task) {
+    if (!CanRedo()) return false;
+    UndoEntry e;
+    memcpy(&e, &undoLog[undoCursor], sizeof(e));
+    applied = (EditKind)e.kind;
+    ApplyEdit(applied, undoCursor, task);
+    undoCursor += UndoEntrySize(e.titleLen);
+    return true;
+}
+
+// --- Lists ---
+
+struct ResidentList {
+    unsigned long fileId;
+    TaskStore tasks;
+    std::vector<wchar_t> arena; // The list's titleArena, so its titles stay valid
+    unsigned long nextId;
+    int selected;
+};
+
+std::vector<ListInfo> lists;
+int activeList = 0;
+std::vector<ResidentList*> residentLists; // Least recently used first
+
+const wchar_t* ActiveListName() {
+    return activeList < (int)lists.size() ? lists[activeList].name.c_str() : L"";
+}
+
+// The next list that is not cold, `delta` steps round from the active one,
+// or the active list if there is no other.
+int StepList(int delta) {
+    int n = (int)lists.size();
+    for (int k = 1; k < n; ++k) {
+        int i = WrapIndex(activeList + delta * k, n);
+        if (!lists[i].cold) return i;
+    }
+    return activeList;
+}
+
+int FindColdList() {
+    for (size_t i = 0; i < lists.size(); ++i) {
+        if (lists[i].cold) return (int)i;
+    }
+    return -1;
+}
+
+void SummarizeActiveList() {
+    if (activeList >= (int)lists.size()) return;
+    ListInfo& info = lists[activeList];
+    info.count = (unsigned long)tasks.size();
+    info.completed = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (tasks[i].completed) ++info.completed;
+    }
+    info.nextId = nextTaskId;
+}
+
+size_t ResidentBytes(const ResidentList& r) {
+    return r.tasks.size() * sizeof(Task) + r.arena.size() * sizeof(wchar_t);
+}
+
+// Moves the active list out of tasks and titleArena, which are left empty.
+void ParkActiveList() {
+    if (activeList < (int)lists.size() && !lists[activeList].cold) {
+        ResidentList* r = new ResidentList;
+        r->fileId = lists[activeList].fileId;
+        r->tasks.swap(tasks);
+        r->arena.swap(titleArena);
+        r->nextId = nextTaskId;
+        r->selected = selectedIndex;
+        residentLists.push_back(r);
+    }
+    tasks.clear();
+    titleArena.clear();
+    selectedIndex = 0;
+}
+
+// Makes a resident list active again; false if it has to be loaded.
+bool RestoreList(unsigned long fileId) {
+    for (size_t i = 0; i < residentLists.size(); ++i) {
+        ResidentList* r = residentLists[i];
+        if (r->fileId != fileId) continue;
+        tasks.swap(r->tasks);
+        titleArena.swap(r->arena);
+        nextTaskId = r->nextId;
+        selectedIndex = r->selected;
+        residentLists.erase(residentLists.begin() + i);
+        delete r;
+        return true;
+    }
+    return false;
+}
+
+void TrimResidentLists(size_t budget) {
+    size_t total = 0;
+    for (size_t i = 0; i < residentLists.size(); ++i) total += ResidentBytes(*residentLists[i]);
+    while (!residentLists.empty() && total > budget) {
+        total -= ResidentBytes(*residentLists[0]);
+        delete residentLists[0];
+        residentLists.erase(residentLists.begin());
+    }
+}
+
+// --- Sync ---
+// Entries are kept in id order, like tasks. An undone delete brings its task
+// back under a new key, because the delete may already have gone out; the
+// tombstone stays just before the new entry so both reach the peers.
+
+int FindTaskIndex(unsigned long id, int from);
+
+unsigned long syncReplica = 0;
+unsigned long syncClock = 0;
+std::vector<SyncEntry> syncEntries;
+std::vector<SyncPeer> syncPeers;
+
+SyncStamp MakeSyncStamp(unsigned long clock, unsigned long replica) {
+    SyncStamp s;
+    s.clock = clock;
+    s.replica = replica;
+    return s;
+}
+
+SyncKey MakeSyncKey(unsigned long origin, unsigned long serial) {
+    SyncKey k;
+    k.origin = origin;
+    k.serial = serial;
+    return k;
+}
+
+bool SyncStampLess(const SyncStamp& a, const SyncStamp& b) {
+    return a.clock != b.clock ? a.clock < b.clock : a.replica < b.replica;
+}
+
+bool SyncStampEqual(const SyncStamp& a, const SyncStamp& b) {
+    return a.clock == b.clock && a.replica == b.replica;
+}
+
+struct SyncKeyLess {
+    bool operator()(const SyncKey& a, const SyncKey& b) const {
+        return a.origin != b.origin ? a.origin < b.origin : a.serial < b.serial;
+    }
+};
+
+bool SyncEntryIdLess(unsigned long id, const SyncEntry& e) {
+    return id < e.id;
+}
+
+unsigned long LatestSyncClock(const SyncEntry& e) {
+    unsigned long c = e.title.clock;
+    if (e.completed.clock > c) c = e.completed.clock;
+    if (e.deleted.clock > c) c = e.deleted.clock;
+    return c;
+}
+
+// FNV-1a over the title's UTF-16 units, so it is the same on every build.
+unsigned long HashSyncTitle(const wchar_t* s, size_t len) {
+    unsigned long h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h = ((h ^ (s[i] & 0xFF)) * 16777619u) & 0xFFFFFFFFu;
+        h = ((h ^ ((s[i] >> 8) & 0xFF)) * 16777619u) & 0xFFFFFFFFu;
+    }
+    return h;
+}
+
+// Position just past the entries for `id`.
+size_t SyncEntryEnd(unsigned long id) {
+    if (syncEntries.empty() || syncEntries.back().id < id) return syncEntries.size();
+    return std::upper_bound(syncEntries.begin(), syncEntries.end(), id, SyncEntryIdLess) - syncEntries.begin();
+}
+
+// The newest entry for the task, or 0.
+SyncEntry* FindSyncEntry(unsigned long id) {
+    size_t end = SyncEntryEnd(id);
+    return (end > 0 && syncEntries[end - 1].id == id) ? &syncEntries[end - 1] : 0;
+}
+
+SyncEntry& AddSyncEntry(const SyncKey& key, unsigned long id, const SyncStamp& stamp) {
+    SyncEntry e;
+    e.key = key;
+    e.id = id;
+    e.title = stamp;
+    e.completed = stamp;
+    e.deleted = MakeSyncStamp(0, 0);
+    size_t at = SyncEntryEnd(id);
+    syncEntries.insert(syncEntries.begin() + at, e);
+    return syncEntries[at];
+}
+
+void ResetSync() {
+    syncReplica = 0;
+    syncClock = 0;
+    syncEntries.clear();
+    syncPeers.clear();
+}
+
+void EnableSync(unsigned long replica) {
+    ResetSync();
+    syncReplica = replica;
+    syncClock = 1; // A first delta is not taken for one already merged (seen 0)
+    std::map<unsigned long, unsigned long> occurrences; // Title hash to tasks seen with it
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const Task& t = tasks[i];
+        unsigned long hash = HashSyncTitle(t.title.c_str(), t.title.size());
+        AddSyncEntry(MakeSyncKey(occurrences[hash]++, hash), t.id, MakeSyncStamp(0, 0));
+    }
+}
+
+// Stamps adds and deletes the saved state missed, as when the app did not
+// exit cleanly after them; tasks is the journal's word.
+void ReconcileSync() {
+    if (!syncReplica) return;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        SyncEntry* e = FindSyncEntry(tasks[i].id);
+        if (!e || e->deleted.clock) NoteSyncEdit(SYNC_ADD, tasks[i]);
+    }
+    int from = 0;
+    for (size_t i = 0; i < syncEntries.size(); ++i) {
+        SyncEntry& e = syncEntries[i];
+        if (e.deleted.clock) continue;
+        int at = FindTaskIndex(e.id, from);
+        if (at < 0) e.deleted = MakeSyncStamp(++syncClock, syncReplica);
+        else from = at;
+    }
+}
+
+void NoteSyncEdit(SyncField field, const Task& t) {
+    if (!syncReplica) return;
+    SyncStamp stamp = MakeSyncStamp(++syncClock, syncReplica);
+    SyncEntry* e = FindSyncEntry(t.id);
+    if (!e || (field == SYNC_ADD && e->deleted.clock)) {
+        if (field != SYNC_DELETE) AddSyncEntry(MakeSyncKey(syncReplica, stamp.clock), t.id, stamp);
+        return;
+    }
+    if (field == SYNC_DELETE) e->deleted = stamp;
+    else if (field == SYNC_COMPLETED) e->completed = stamp;
+    else if (field == SYNC_TITLE) e->title = stamp;
+    else e->title = e->completed = stamp;
+}
+
+// Our clock that every known peer has merged up to; 0 if there are none.
+unsigned long SyncAckedClock() {
+    if (syncPeers.empty()) return 0;
+    unsigned long acked = syncPeers[0].ack;
+    for (size_t i = 1; i < syncPeers.size(); ++i) {
+        if (syncPeers[i].ack < acked) acked = syncPeers[i].ack;
+    }
+    return acked;
+}
+
+// Everything changed since the peers last merged, or the whole list,
+// including what predates sync, if no peer has merged anything yet.
+void CollectSyncDelta(std::vector<SyncRecord>& out) {
+    unsigned long since = SyncAckedClock();
+    int from = 0;
+    for (size_t i = 0; i < syncEntries.size(); ++i) {
+        const SyncEntry& e = syncEntries[i];
+        if (since > 0 && LatestSyncClock(e) <= since) continue;
+        SyncRecord r;
+        r.key = e.key;
+        r.title = e.title;
+        r.completed = e.completed;
+        r.deleted = e.deleted;
+        r.isCompleted = false;
+        if (!e.deleted.clock) {
+            int at = FindTaskIndex(e.id, from);
+            if (at < 0) continue;
+            from = at;
+            r.isCompleted = tasks[at].completed;
+            r.text.assign(tasks[at].title.c_str(), tasks[at].title.size());
+        }
+        out.push_back(r);
+    }
+}
+
+// Tombstones every peer has merged can go.
+void PruneSyncTombstones() {
+    unsigned long acked = SyncAckedClock();
+    size_t kept = 0;
+    for (size_t i = 0; i < syncEntries.size(); ++i) {
+        const SyncEntry& e = syncEntries[i];
+        if (e.deleted.clock && e.deleted.clock <= acked) continue;
+        syncEntries[kept++] = e;
+    }
+    syncEntries.resize(kept);
+}
+
+SyncPeer& FindSyncPeer(unsigned long replica) {
+    for (size_t i = 0; i < syncPeers.size(); ++i) {
+        if (syncPeers[i].replica == replica) return syncPeers[i];
+    }
+    SyncPeer p;
+    p.replica = replica;
+    p.seen = 0;
+    p.ack = 0;
+    syncPeers.push_back(p);
+    return syncPeers.back();
+}
+
+void AdvanceSyncClock(const SyncStamp& s) {
+    if (s.clock > syncClock) syncClock = s.clock;
+}
+
+bool MergeSyncDelta(unsigned long from, unsigned long clock, unsigned long ack,
+                    const std::vector<SyncRecord>& in, std::vector<SyncChange>& changes) {
+    if (!syncReplica || from == syncReplica) return false;
+    SyncPeer& peer = FindSyncPeer(from);
+    if (ack > peer.ack) peer.ack = ack; // A delta with nothing new can still confirm ours
+    if (clock <= peer.seen) return false;
+
+    std::map<SyncKey, size_t, SyncKeyLess> byKey;
+    for (size_t i = 0; i < syncEntries.size(); ++i) byKey[syncEntries[i].key] = i;
+
+    for (size_t k = 0; k < in.size(); ++k) {
+        const SyncRecord& r = in[k];
+        AdvanceSyncClock(r.title);
+        AdvanceSyncClock(r.completed);
+        AdvanceSyncClock(r.deleted);
+        SyncChange change;
+
+        std::map<SyncKey, size_t, SyncKeyLess>::iterator it = byKey.find(r.key);
+        if (it == byKey.end()) {
+            if (r.deleted.clock) continue; // Never had it
+            change.field = SYNC_ADD;
+            change.task = MakeTask(r.text); // Largest id yet, so entries stay in order
+            change.task.completed = r.isCompleted;
+            tasks.push_back(change.task);
+            IndexTask(change.task);
+            ViewTask(change.task);
+            SyncEntry& e = AddSyncEntry(r.key, change.task.id, r.title);
+            e.completed = r.completed;
+            byKey[r.key] = syncEntries.size() - 1;
+            changes.push_back(change);
+            continue;
+        }
+
+        SyncEntry& e = syncEntries[it->second];
+        if (e.deleted.clock) {
+            if (SyncStampLess(e.deleted, r.deleted)) e.deleted = r.deleted;
+            continue;
+        }
+        int at = FindTaskIndex(e.id);
+        if (r.deleted.clock) {
+            e.deleted = r.deleted;
+            if (at < 0) continue;
+            change.field = SYNC_DELETE;
+            change.task = tasks[at];
+            UnindexTask(change.task);
+            UnviewTask(change.task);
+            tasks.erase(at);
+            changes.push_back(change);
+            continue;
+        }
+        if (at < 0) continue;
+
+        Task& t = tasks[at];
+        bool titleWins = SyncStampLess(e.title, r.title) ||
+                         (SyncStampEqual(e.title, r.title) && r.text.compare(t.title.c_str()) > 0);
+        if (titleWins) {
+            e.title = r.title;
+            if (r.text.compare(t.title.c_str()) != 0) {
+                UnindexTask(t);
+                t.title = TaskTitle(r.text);
+                IndexTask(t);
+                change.field = SYNC_TITLE;
+                change.task = t;
+                changes.push_back(change);
+            }
+        }
+        bool completedWins = SyncStampLess(e.completed, r.completed) ||
+                             (SyncStampEqual(e.completed, r.completed) && r.isCompleted && !t.completed);
+        if (completedWins) {
+            e.completed = r.completed;
+            if (t.completed != r.isCompleted) {
+                UnviewTask(t);
+                t.completed = r.isCompleted;
+                ViewTask(t);
+                change.field = SYNC_COMPLETED;
+                change.task = t;
+                changes.push_back(change);
+            }
+        }
+    }
+
+    peer.seen = clock;
+    if (clock > syncClock) syncClock = clock;
+    PruneSyncTombstones();
+    if (selectedIndex >= (int)tasks.size()) selectedIndex = (int)tasks.size() - 1;
+    if (selectedIndex < 0) selectedIndex = 0;
+    SnapScroll(selectedIndex);
+    return true;
+}
+
+// --- Search ---
+// Every title is indexed by each distinct 1, 2 and 3 character substring of
+// its folded text, mapped to the sorted ids of the tasks containing it. A
+// query of up to three characters is therefore answered exactly by one
+// posting list. Each further character only narrows the previous result by
+// the posting list of the query's last three characters, and the few
+// survivors are checked against the whole query. Backspace pops back to the
+// result kept for the shorter query. The index is built on the first search
+// and kept current on add and delete from then on.
+//
+// Results are task ids. Tasks are only ever appended with fresh ids, or put
+// back where they were by undo, so ids ascend along the list and a result
+// maps back to a position by binary search.
+
+#define SEARCH_GRAM_MAX 3
+
+typedef unsigned long long SearchKey; // Gram length, then up to three UTF-16 units
+typedef std::vector<unsigned long> IdList;
+
+std::map<SearchKey, IdList> searchIndex;
+bool searchIndexBuilt = false;
+std::wstring searchQuery;
+std::vector<IdList> searchResults; // searchResults[k] matches the first k + 1 characters
+int searchSavedIndex = 0;
+
+// Case- and width-insensitive: fullwidth ASCII folds to ASCII, then A-Z to a-z.
+// Kana and kanji are matched as they are.
+wchar_t FoldSearchChar(wchar_t c) {
+    if (c >= 0xFF01 && c <= 0xFF5E) c = (wchar_t)(c - 0xFEE0);
+    else if (c == 0x3000) c = L' '; // Ideographic space
+    if (c >= L'A' && c <= L'Z') c = (wchar_t)(c + (L'a' - L'A'));
+    return c;
+}
+
+SearchKey MakeSearchKey(const wchar_t* folded, size_t len) {
+    SearchKey key = (SearchKey)len << 48;
+    for (size_t k = 0; k < len; ++k) key |= (SearchKey)(unsigned short)folded[k] << (16 * (2 - k));
+    return key;
+}
+
+void FoldSearchText(const wchar_t* s, size_t len, std::wstring& out) {
+    out.resize(len);
+    for (size_t k = 0; k < len; ++k) out[k] = FoldSearchChar(s[k]);
+}
+
+void CollectSearchKeys(const Task& t, std::vector<SearchKey>& keys) {
+    std::wstring folded;
+    FoldSearchText(t.title.c_str(), t.title.size(), folded);
+    keys.clear();
+    for (size_t i = 0; i < folded.size(); ++i) {
+        for (size_t len = 1; len <= SEARCH_GRAM_MAX && i + len <= folded.size(); ++len) {
+            keys.push_back(MakeSearchKey(folded.data() + i, len));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+void AddToSearchIndex(const Task& t) {
+    std::vector<SearchKey> keys;
+    CollectSearchKeys(t, keys);
+    for (size_t k = 0; k < keys.size(); ++k) {
+        IdList& ids = searchIndex[keys[k]];
+        if (ids.empty() || ids.back() < t.id) ids.push_back(t.id);
+        else ids.insert(std::lower_bound(ids.begin(), ids.end(), t.id), t.id);
+    }
+}
+
+void IndexTask(const Task& t) {
+    if (searchIndexBuilt) AddToSearchIndex(t);
+}
+
+void UnindexTask(const Task& t) {
+    if (!searchIndexBuilt) return;
+    std::vector<SearchKey> keys;
+    CollectSearchKeys(t, keys);
+    for (size_t k = 0; k < keys.size(); ++k) {
+        std::map<SearchKey, IdList>::iterator it = searchIndex.find(keys[k]);
+        if (it == searchIndex.end()) continue;
+        IdList::iterator pos = std::lower_bound(it->second.begin(), it->second.end(), t.id);
+        if (pos != it->second.end() && *pos == t.id) it->second.erase(pos);
+        if (it->second.empty()) searchIndex.erase(it);
+    }
+}
+
+void ResetSearchIndex() {
+    searchIndex.clear();
+    searchIndexBuilt = false;
+}
+
+// Position of the task with this id at or after `from`, or -1. Gallops
+// forward from `from` first, so walking ascending ids costs little more than
+// a scan when they are dense and a binary search when they are sparse. Ids
+// ascend along tasks (FinishLoadTasks sorts a hand-edited file), so a
+// missing id costs no more than a present one.
+int FindTaskIndex(unsigned long id, int from) {
+    int n = (int)tasks.size();
+    int lo = from;
+    int hi = n - 1;
+    for (int step = 1; lo + step - 1 < n; step *= 2) {
+        unsigned long probeId = tasks[lo + step - 1].id;
+        if (probeId == id) return lo + step - 1;
+        if (probeId > id) {
+            hi = lo + step - 2;
+            break;
+        }
+        lo += step;
+    }
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        unsigned long midId = tasks[mid].id;
+        if (midId == id) return mid;
+        if (midId < id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+int FindTaskIndex(unsigned long id) {
+    return tasks.FindId(id);
+}
+
+bool TitleContains(const TaskTitle& title, const std::wstring& folded) {
+    const wchar_t* s = title.c_str();
+    size_t len = title.size();
+    if (folded.size() > len) return false;
+    for (size_t start = 0; start + folded.size() <= len; ++start) {
+        size_t k = 0;
+        while (k < folded.size() && FoldSearchChar(s[start + k]) == folded[k]) ++k;
+        if (k == folded.size()) return true;
+    }
+    return false;
+}
+
+bool IsFiltered() {
+    return currentMode == MODE_SEARCH && !searchResults.empty();
+}
+
+size_t ViewSize() {
+    return IsFiltered() ? searchResults.back().size() : tasks.size();
+}
+
+unsigned long ViewIdAt(int j);
+
+int ViewToTask(int j) {
+    if (IsFiltered()) return FindTaskIndex(searchResults.back()[j]);
+    if (viewOrder == ORDER_LIST) return j;
+    return FindTaskIndex(ViewIdAt(j));
+}
+
+void BeginSearch() {
+    if (!searchIndexBuilt) {
+        for (size_t i = 0; i < tasks.size(); ++i) AddToSearchIndex(tasks[i]);
+        searchIndexBuilt = true;
+    }
+    searchSavedIndex = selectedIndex;
+    searchQuery.clear();
+    searchResults.clear();
+    currentMode = MODE_SEARCH;
+}
+
+void RefineSearch() {
+    std::wstring folded;
+    FoldSearchText(searchQuery.data(), searchQuery.size(), folded);
+    size_t len = folded.size();
+    size_t gramLen = len < SEARCH_GRAM_MAX ? len : SEARCH_GRAM_MAX;
+    std::map<SearchKey, IdList>::const_iterator it = searchIndex.find(MakeSearchKey(folded.data() + len - gramLen, gramLen));
+
+    IdList result;
+    if (it != searchIndex.end()) {
+        if (searchResults.empty()) {
+            result = it->second;
+        } else {
+            const IdList& prev = searchResults.back();
+            std::set_intersection(prev.begin(), prev.end(), it->second.begin(), it->second.end(), std::back_inserter(result));
+        }
+    }
+
+    if (len > SEARCH_GRAM_MAX) {
+        // The last gram is necessary but not sufficient; check the whole query.
+        // Candidates ascend, so each lookup starts past the previous one.
+        size_t live = 0;
+        int from = 0;
+        for (size_t k = 0; k < result.size(); ++k) {
+            int i = FindTaskIndex(result[k], from);
+            if (i < 0) continue;
+            from = i + 1;
+            if (TitleContains(tasks[i].title, folded)) result[live++] = result[k];
+        }
+        result.resize(live);
+    }
+    searchResults.push_back(result);
+}
+
+// Backspace (L'\b') or a printable character; the wheel jumps to the first match.
+bool EditSearchQuery(wchar_t ch) {
+    if (ch == L'\b') {
+        if (searchQuery.empty()) return false;
+        searchQuery.erase(searchQuery.size() - 1);
+        searchResults.pop_back();
+    } else if (ch >= 32) {
+        searchQuery += ch;
+        RefineSearch();
+    } else {
+        return false;
+    }
+    selectedIndex = 0;
+    if (!IsFiltered()) selectedIndex = searchSavedIndex;
+    SnapScroll(selectedIndex);
+    return true;
+}
+
+// Enter keeps the selected match; Escape returns to where the search began.
+void EndSearch(bool commit) {
+    int kept = (commit && ViewSize() > 0) ? ViewToTask(selectedIndex) : -1;
+    searchQuery.clear();
+    searchResults.clear();
+    currentMode = MODE_LIST;
+    selectedIndex = kept >= 0 ? TaskToView(kept) : searchSavedIndex;
+    SnapScroll(selectedIndex);
+}
+
+// --- Views ---
+// Nodes live in one vector and link by index; removed nodes are chained
+// through `left` for reuse. The key packs the order's sort key above the id,
+// so keys are unique and ties fall back to list order.
+
+typedef unsigned long long ViewKey;
+
+struct ViewNode {
+    ViewKey key;
+    int left;
+    int right;
+    unsigned long size;
+    unsigned long weight; // Heap priority: a node outweighs its children
+};
+
+ViewOrder viewOrder = ORDER_LIST;
+std::vector<ViewNode> viewNodes;
+int viewRoot = -1;
+int viewFree = -1;
+bool viewIndexBuilt = false;
+unsigned long viewSeed = 1;
+
+// Weights keep the top bit clear so a bulk build can raise them.
+unsigned long NextViewWeight() {
+    viewSeed = viewSeed * 1103515245UL + 12345UL;
+    return (viewSeed >> 1) & 0x7FFFFFFFUL;
+}
+
+ViewKey MakeViewKey(const Task& t) {
+    unsigned long primary = 0;
+    if (viewOrder == ORDER_OPEN_FIRST) primary = t.completed ? 1 : 0;
+    else if (viewOrder == ORDER_DUE) primary = t.due ? t.due : 0x10000UL; // Undated last
+    else if (viewOrder == ORDER_PRIORITY) primary = t.priority ? t.priority : PRIORITY_LEVELS + 1;
+    return ((ViewKey)primary << 32) | (t.id & 0xFFFFFFFFUL);
+}
+
+unsigned long ViewNodeSize(int n) {
+    return n < 0 ? 0 : viewNodes[n].size;
+}
+
+void UpdateViewNode(int n) {
+    viewNodes[n].size = 1 + ViewNodeSize(viewNodes[n].left) + ViewNodeSize(viewNodes[n].right);
+}
+
+int NewViewNode(ViewKey key, unsigned long weight) {
+    int n;
+    if (viewFree >= 0) {
+        n = viewFree;
+        viewFree = viewNodes[n].left;
+    } else {
+        n = (int)viewNodes.size();
+        viewNodes.push_back(ViewNode());
+    }
+    ViewNode& node = viewNodes[n];
+    node.key = key;
+    node.left = node.right = -1;
+    node.size = 1;
+    node.weight = weight;
+    return n;
+}
+
+// Keys below `key` go to `left`, the rest to `right`.
+void SplitView(int n, ViewKey key, int& left, int& right) {
+    if (n < 0) {
+        left = right = -1;
+        return;
+    }
+    if (viewNodes[n].key < key) {
+        SplitView(viewNodes[n].right, key, viewNodes[n].right, right);
+        left = n;
+    } else {
+        SplitView(viewNodes[n].left, key, left, viewNodes[n].left);
+        right = n;
+    }
+    UpdateViewNode(n);
+}
+
+// Every key in `left` is below every key in `right`.
+int JoinView(int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+    if (viewNodes[left].weight > viewNodes[right].weight) {
+        int joined = JoinView(viewNodes[left].right, right);
+        viewNodes[left].right = joined;
+        UpdateViewNode(left);
+        return left;
+    }
+    int joined = JoinView(left, viewNodes[right].left);
+    viewNodes[right].left = joined;
+    UpdateViewNode(right);
+    return right;
+}
+
+// Balanced tree over sorted keys [lo, hi); each weight is lifted above its
+// children's so the result is a valid heap.
+int BuildView(const std::vector<ViewKey>& keys, size_t lo, size_t hi) {
+    if (lo >= hi) return -1;
+    size_t mid = lo + (hi - lo) / 2;
+    int left = BuildView(keys, lo, mid);
+    int right = BuildView(keys, mid + 1, hi);
+    unsigned long weight = NextViewWeight();
+    if (left >= 0 && viewNodes[left].weight >= weight) weight = viewNodes[left].weight + 1;
+    if (right >= 0 && viewNodes[right].weight >= weight) weight = viewNodes[right].weight + 1;
+    int n = NewViewNode(keys[mid], weight);
+    viewNodes[n].left = left;
+    viewNodes[n].right = right;
+    UpdateViewNode(n);
+    return n;
+}
+
+void EnsureViewIndex() {
+    if (viewIndexBuilt || viewOrder == ORDER_LIST) return;
+    std::vector<ViewKey> keys(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) keys[i] = MakeViewKey(tasks[i]);
+    std::sort(keys.begin(), keys.end());
+    viewNodes.reserve(keys.size());
+    viewRoot = BuildView(keys, 0, keys.size());
+    viewIndexBuilt = true;
+}
+
+void ResetViewIndex() {
+    viewNodes.clear();
+    viewRoot = -1;
+    viewFree = -1;
+    viewIndexBuilt = false;
+}
+
+// Puts node n in the subtree at `root` in one descent: it goes where its
+// weight first beats the path's, with that subtree split around it.
+int InsertView(int root, int n) {
+    if (root < 0) return n;
+    ViewNode& node = viewNodes[root];
+    if (viewNodes[n].weight > node.weight) {
+        SplitView(root, viewNodes[n].key, viewNodes[n].left, viewNodes[n].right);
+        UpdateViewNode(n);
+        return n;
+    }
+    if (viewNodes[n].key < node.key) {
+        int child = InsertView(node.left, n);
+        viewNodes[root].left = child;
+    } else {
+        int child = InsertView(node.right, n);
+        viewNodes[root].right = child;
+    }
+    ++viewNodes[root].size;
+    return root;
+}
+
+// Takes the node with this key out of the subtree at `root` and frees it.
+int EraseView(int root, ViewKey key) {
+    if (root < 0) return -1;
+    ViewNode& node = viewNodes[root];
+    if (node.key == key) {
+        int joined = JoinView(node.left, node.right);
+        viewNodes[root].left = viewFree;
+        viewFree = root;
+        return joined;
+    }
+    if (key < node.key) {
+        int child = EraseView(node.left, key);
+        viewNodes[root].left = child;
+    } else {
+        int child = EraseView(node.right, key);
+        viewNodes[root].right = child;
+    }
+    UpdateViewNode(root);
+    return root;
+}
+
+void ViewTask(const Task& t) {
+    if (!viewIndexBuilt) return;
+    int n = NewViewNode(MakeViewKey(t), NextViewWeight());
+    viewRoot = InsertView(viewRoot, n);
+}
+
+void UnviewTask(const Task& t) {
+    if (!viewIndexBuilt) return;
+    viewRoot = EraseView(viewRoot, MakeViewKey(t));
+}
+
+unsigned long ViewIdAt(int j) {
+    EnsureViewIndex();
+    int n = viewRoot;
+    unsigned long k = (unsigned long)j;
+    while (n >= 0) {
+        unsigned long leftSize = ViewNodeSize(viewNodes[n].left);
+        if (k < leftSize) {
+            n = viewNodes[n].left;
+        } else if (k == leftSize) {
+            return (unsigned long)(viewNodes[n].key & 0xFFFFFFFFUL);
+        } else {
+            k -= leftSize + 1;
+            n = viewNodes[n].right;
+        }
+    }
+    return 0;
+}
+
+// View row of a task outside a filtered search.
+int TaskToView(int index) {
+    if (viewOrder == ORDER_LIST || index < 0) return index;
+    EnsureViewIndex();
+    ViewKey key = MakeViewKey(tasks[index]);
+    unsigned long row = 0;
+    int n = viewRoot;
+    while (n >= 0) {
+        if (viewNodes[n].key < key) {
+            row += ViewNodeSize(viewNodes[n].left) + 1;
+            n = viewNodes[n].right;
+        } else {
+            n = viewNodes[n].left;
+        }
+    }
+    return (int)row;
+}
+
+const wchar_t* ViewOrderName() {
+    switch (viewOrder) {
+        case ORDER_OPEN_FIRST: return L"Open first";
+        case ORDER_DUE: return L"By due";
+        case ORDER_PRIORITY: return L"By priority";
+        default: return L"";
+    }
+}
+
+// Keeps the selected task under the focus frame.
+void SetViewOrder(ViewOrder order) {
+    int task = ViewSize() > 0 ? ViewToTask(selectedIndex) : -1;
+    ResetViewIndex();
+    viewOrder = order;
+    if (task >= 0) selectedIndex = TaskToView(task);
+    SnapScroll(selectedIndex);
+}
+
+bool SetTaskPriority(int index, int priority) {
+    if (index < 0 || index >= (int)tasks.size() || priority < 0 || priority > PRIORITY_LEVELS) return false;
+    if (tasks[index].priority == priority) return false;
+    UnviewTask(tasks[index]);
+    tasks[index].priority = (unsigned char)priority;
+    ViewTask(tasks[index]);
+    return true;
+}
+
+bool SetTaskDue(int index, unsigned short due) {
+    if (index < 0 || index >= (int)tasks.size() || tasks[index].due == due) return false;
+    UnviewTask(tasks[index]);
+    tasks[index].due = due;
+    ViewTask(tasks[index]);
+    return true;
+}
+
+// --- Layout ---
+
+LayoutRect MakeLayoutRect(int left, int top, int right, int bottom) {
+    LayoutRect r = { left, top, right, bottom };
+    return r;
+}
+
+bool RectsOverlap(const LayoutRect& a, const LayoutRect& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+LayoutRect GetHeaderRect(int width, int height) {
+    (void)height;
+    return MakeLayoutRect(MARGIN_X, MARGIN_Y / 2, width - MARGIN_X, MARGIN_Y);
+}
+
+LayoutRect GetFooterRect(int width, int height) {
+    return MakeLayoutRect(MARGIN_X, height - 20, width - MARGIN_X, height - 5);
+}
+
+// Row `slot` positions away from the focus frame, with the list at rest.
+LayoutRect GetRowRect(int width, int height, int slot) {
+    int top = height / 2 - ITEM_HEIGHT / 2 + slot * ROW_SPACING;
+    return MakeLayoutRect(0, top, width, top + ITEM_HEIGHT);
+}
+
+// Alpha based on distance from screen center
+int GetRowAlpha(int distFromCenter, int centerY) {
+    int alpha = 255 - (distFromCenter * 255 / centerY);
+    if (alpha < 40) alpha = 40;
+    if (alpha > 255) alpha = 255;
+    return alpha;
+}
+
+// --- Frame Commands ---
+
+FrameStats EmitFrame(FrameSink& sink, int width, int height, const LayoutRect& dirty, unsigned long now) {
+    FrameStats stats = { 0, 0 };
+    sink.Background(dirty);
+    ++stats.commands;
+
+    bool editingMode = (currentMode == MODE_ADD);
+    if (ViewSize() > 0) {
+        int centerY = height / 2;
+        int halfItem = ITEM_HEIGHT / 2;
+
+        int rangeJ = (centerY + ROW_SPACING - 1) / ROW_SPACING + 1;
+        int startJ = FIX_FLOOR(visualScrollPos) - rangeJ;
+        int endJ = FIX_FLOOR(visualScrollPos) + rangeJ + 1;
+        int n = (int)ViewSize();
+
+        // Stationary Focus Frame
+        LayoutRect focusRect = MakeLayoutRect(MARGIN_X, centerY - halfItem, width - MARGIN_X, centerY - halfItem + ITEM_HEIGHT);
+        if (RectsOverlap(focusRect, dirty)) {
+            sink.FocusFrame(focusRect, editingMode);
+            ++stats.commands;
+        }
+
+        for (int j = startJ; j <= endJ; ++j) {
+            ++stats.rowsVisited;
+            int i = ViewToTask(WrapIndex(j, n));
+            int itemTop = centerY - halfItem + (int)(((INT_TO_FIX(j) - visualScrollPos) * ROW_SPACING) >> FIX_SHIFT);
+            LayoutRect itemRect = MakeLayoutRect(MARGIN_X, itemTop, width - MARGIN_X, itemTop + ITEM_HEIGHT);
+
+            // Skip rows whose body and seam (up to 3px below) miss the dirty rect
+            if (itemTop >= dirty.bottom || itemTop + ROW_SPACING + 2 <= dirty.top) continue;
+
+            // Seam Separator (between j=k*n-1 and j=k*n)
+            if ((j % n == n - 1) && n > 1) {
+                int seamY = itemTop + ITEM_HEIGHT + 1;
+                if (seamY > MARGIN_Y && seamY < height - MARGIN_Y) {
+                    sink.Seam(MARGIN_X, width - MARGIN_X, seamY);
+                    ++stats.commands;
+                }
+            }
+
+            if (itemTop + ITEM_HEIGHT < 0 || itemTop > height) continue;
+
+            // Focused: virtual index j is the one closest to visualScrollPos
+            bool isFocused = (j == FIX_ROUND(visualScrollPos));
+            int alpha = isFocused ? 255 : GetRowAlpha(abs(itemTop + halfItem - centerY), centerY);
+
+            sink.Indicator(itemRect, tasks[i].completed);
+
+            LayoutRect textRect = MakeLayoutRect(itemRect.left + TEXT_INDENT, itemRect.top, itemRect.right, itemRect.bottom);
+            bool editing = isFocused && editingMode;
+            bool caret = editing && (now / CARET_BLINK_MS) % 2 == 0;
+            sink.RowTitle(textRect, tasks[i], alpha, editing, caret);
+            stats.commands += 2;
+        }
+    }
+
+    LayoutRect headerRect = GetHeaderRect(width, height);
+    if (RectsOverlap(headerRect, dirty)) {
+        sink.Header(headerRect, currentMode, searchQuery.c_str(), ActiveListName());
+        ++stats.commands;
+    }
+
+    LayoutRect footerRect = GetFooterRect(width, height);
+    if (RectsOverlap(footerRect, dirty)) {
+        sink.Footer(footerRect, currentMode, ViewSize());
+        ++stats.commands;
+    }
+    return stats;
+}
@@ -0,0 +1,484 @@
+/*
+ * TofuMental - Platform-neutral core.
+ * Task model, file formats, input handling, scroll animation and list layout
+ * with no Win32 dependency. A frame is described to a FrameSink, which the window code
+ * implements with GDI and the RGB565 canvas; anything else (a headless host,
+ * a profiler) can implement it too.
+ */
+
+#ifndef TOFU_CORE_H
+#define TOFU_CORE_H
+
+#include <stddef.h>
+#include <vector>
+#include <string>
+#include <map>
+
+// --- Design Constants (8pt Grid) ---
+#define GRID_UNIT 8
+#define MARGIN_X (GRID_UNIT * 3) // 24pt
+#define MARGIN_Y (GRID_UNIT * 4) // 32pt
+#define ITEM_HEIGHT (GRID_UNIT * 6) // 48pt
+#define ROW_SPACING (ITEM_HEIGHT + 2)
+#define TEXT_INDENT (GRID_UNIT * 5) // Indicator column, then the title
+#define CORNER_RADIUS GRID_UNIT
+
+// --- Task Model ---
+// Titles read from disk are views into titleArena, which is the loaded file
+// buffer itself with each title NUL-terminated in place. A title is copied
+// out of the arena only when it is edited.
+extern std::vector<wchar_t> titleArena;
+extern unsigned long titleRevisions; // Every new or edited title gets a fresh revision
+
+class TaskTitle {
+public:
+    TaskTitle() : offset(0), length(0), inArena(false), revision(++titleRevisions) {}
+    TaskTitle(const std::wstring& s) : text(s), offset(0), length(0), inArena(false), revision(++titleRevisions) {}
+
+    static TaskTitle FromArena(size_t offset, size_t length) {
+        TaskTitle t;
+        t.offset = (unsigned long)offset;
+        t.length = (unsigned long)length;
+        t.inArena = true;
+        return t;
+    }
+
+    const wchar_t* c_str() const { return inArena ? &titleArena[offset] : text.c_str(); }
+    size_t size() const { return inArena ? length : text.size(); }
+    bool empty() const { return size() == 0; }
+    unsigned long Revision() const { return revision; }
+
+    std::wstring& Edit() {
+        if (inArena) {
+            text.assign(&titleArena[offset], length);
+            inArena = false;
+        }
+        revision = ++titleRevisions;
+        return text;
+    }
+
+private:
+    std::wstring text;
+    unsigned long offset;
+    unsigned long length;
+    bool inArena;
+    unsigned long revision;
+};
+
+struct Task {
+    TaskTitle title;
+    bool completed;
+    unsigned char priority; // 0 for none, else 1 (highest) to PRIORITY_LEVELS
+    unsigned short due;     // DayNumber() of the due day, 0 for none
+    unsigned long id; // Stable key for journal records, 0 is never assigned
+    Task() : completed(false), priority(0), due(0), id(0) {}
+    Task(const std::wstring& t) : title(t), completed(false), priority(0), due(0), id(0) {}
+};
+
+#define PRIORITY_LEVELS 3
+
+// Days since 1999-12-31, so 2000-01-01 is day 1 and 0 can mean no day.
+unsigned short DayNumber(int year, int month, int day);
+void DayToDate(unsigned short dayNumber, int& year, int& month, int& day);
+
+// Tasks are held in chunks of up to TASK_CHUNK_MAX, with a Fenwick tree over
+// the chunk sizes to find the chunk holding an index in O(log n). Inserting
+// or erasing moves at most one chunk's worth of tasks; only a chunk split or
+// merge touches the chunk table. Sequential access is O(1) through a cached
+// last-chunk hint, so full scans stay linear.
+#define TASK_CHUNK_MAX 64
+#define TASK_CHUNK_MIN (TASK_CHUNK_MAX / 4) // Smaller chunks merge into a neighbour
+#define TASK_CHUNK_FILL (TASK_CHUNK_MAX * 3 / 4) // Appends leave room for inserts
+
+class TaskStore {
+public:
+    TaskStore();
+    TaskStore(const TaskStore& other);
+    TaskStore& operator=(const TaskStore& other);
+    ~TaskStore();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    Task& operator[](size_t i);
+    const Task& operator[](size_t i) const;
+    Task& back() { return chunks.back()->items.back(); }
+    int FindId(unsigned long id) const;
+
+    void push_back(const Task& t);
+    void insert(size_t pos, const Task& t);
+    void erase(size_t pos);
+    void clear();
+    void swap(TaskStore& other);
+
+private:
+    struct Chunk {
+        std::vector<Task> items;
+    };
+
+    size_t Locate(size_t i, size_t& offset) const;
+    void AddToIndex(size_t chunk, long delta);
+    void RebuildIndex();
+    void CopyFrom(const TaskStore& other);
+
+    std::vector<Chunk*> chunks;
+    std::vector<size_t> fenwick; // 1-based partial sums of chunk sizes
+    size_t count;
+    mutable size_t hintChunk; // Chunk of the last lookup, or chunks.size() if none
+    mutable size_t hintStart; // Index of its first task
+};
+
+enum AppMode { MODE_LIST, MODE_ADD, MODE_SEARCH };
+
+extern TaskStore tasks;
+extern unsigned long nextTaskId;
+extern int selectedIndex;
+extern AppMode currentMode;
+
+Task MakeTask(const std::wstring& title);
+
+// --- File Formats ---
+// What tasks.dat, tasks.log and the legacy tasks.txt hold, shared by the
+// window code and the host tools; the file I/O is the caller's. Fields are
+// little-endian and fixed-width (unsigned int is 32 bits on every target),
+// and titles are UTF-16 units however wide wchar_t is.
+#define SNAPSHOT_MAGIC L"#TOFU 2" // Text snapshots (tasks.txt), read for migration only
+
+// tasks.dat: header, count fixed-width records, then the title heap. The heap
+// is UTF-16LE with every title NUL-terminated, so the file read as a whole
+// becomes titleArena and no title is decoded or copied on load. (UTF-8 would
+// save space on ASCII titles but cost it on kana and kanji, and every title
+// would have to be converted before GDI could draw it.)
+#define SNAPSHOT_FILE_MAGIC 0x55464F54 // "TOFU"
+#define SNAPSHOT_VERSION 4
+#define SNAPSHOT_V3_RECORD_BYTES 12 // Version 3 records end before due
+#define SNAPSHOT_COMPLETED 0x0001
+
+struct SnapshotHeader {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short headerSize;
+    unsigned int nextId;
+    unsigned int count;
+    unsigned int heapChars; // UTF-16 units in the title heap
+    unsigned int crc;       // CRC-32 of the records and heap
+};
+
+struct SnapshotRecord {
+    unsigned int id;
+    unsigned int titleOffset; // Units from the start of the heap
+    unsigned short titleLen;
+    unsigned short flags;
+    unsigned short due;
+    unsigned char priority;
+    unsigned char reserved;
+};
+
+enum JournalOp { JOP_ADD = 1, JOP_DELETE = 2, JOP_SET_COMPLETED = 3, JOP_SET_TITLE = 4, JOP_SET_PLAN = 5 };
+
+// tasks.log: per change a header, titleLen units, then a checksum of both.
+// JOP_SET_PLAN carries the priority in `completed` and the due day as its one
+// title unit.
+struct JournalRecord {
+    unsigned int id;
+    unsigned char op;
+    unsigned char completed;
+    unsigned short titleLen;
+};
+
+// Continues a CRC-32 started at CRC32_INIT; the result is crc ^ CRC32_INIT.
+#define CRC32_INIT 0xFFFFFFFFu
+
+unsigned int Crc32Update(unsigned int crc, const unsigned char* data, size_t len);
+unsigned int Crc32(const unsigned char* data, size_t len);
+unsigned int JournalChecksum(const unsigned char* data, size_t len);
+
+// Appends `bytes` of UTF-16LE to titleArena, one wchar_t per unit.
+void AppendArenaUnits(const unsigned char* data, size_t bytes);
+TaskTitle AppendArenaTitle(const unsigned char* units, size_t len);
+
+// Appends one checksummed record to out; an add with a plan is followed by
+// a JOP_SET_PLAN record.
+void EncodeJournalRecord(unsigned char op, const Task& t, std::vector<unsigned char>& out);
+// Applies the records at the start of data to tasks, given the position of
+// each id in it. Deleted tasks are left with id 0 for the caller to sweep.
+// Returns the bytes applied: past that is a torn or corrupt tail.
+size_t ReplayJournalRecords(const unsigned char* data, size_t size, std::map<unsigned long, size_t>& index);
+
+void EncodeSnapshot(const TaskStore& list, unsigned long nextId, std::vector<unsigned char>& out);
+// Bytes per record if the header fits a file of fileSize bytes, else 0.
+size_t CheckSnapshotHeader(const SnapshotHeader& header, size_t fileSize);
+// Record i, with the fields a version 3 record lacks left zero.
+SnapshotRecord GetSnapshotRecord(const unsigned char* records, size_t recordBytes, size_t i);
+// Appends records [from, to) to out. Titles are views of the heap, which
+// starts `heapStart` units into titleArena.
+void BuildSnapshotTasks(const SnapshotHeader& header, const unsigned char* records, size_t recordBytes,
+                        size_t from, size_t to, size_t heapStart, TaskStore& out);
+// A preview is records read on their own and the stretch of heap their
+// titles span, which is contiguous for consecutive records. PreviewHeapRange
+// gives that stretch as units [lo, hi) of the heap, empty if the records are
+// damaged; AppendPreviewTasks appends the records to tasks with their titles
+// copied out of it.
+void PreviewHeapRange(const unsigned char* records, size_t recordBytes, size_t count, size_t& lo, size_t& hi);
+void AppendPreviewTasks(const unsigned char* records, size_t recordBytes, size_t count,
+                        const unsigned char* heap, size_t lo, size_t hi);
+
+#define LOAD_PREVIEW_ROWS 8 // Records from each end: all the wheel shows around row 0
+
+// Where a preview reads the snapshot from; false on a short read.
+class SnapshotReader {
+public:
+    virtual ~SnapshotReader() {}
+    virtual bool ReadAt(size_t offset, void* buffer, size_t bytes) = 0;
+};
+
+// Appends the first and last LOAD_PREVIEW_ROWS records of a snapshot whose
+// header has passed CheckSnapshotHeader to tasks, or all of them if there
+// are no more than twice that, in two reads per end.
+void LoadSnapshotPreview(const SnapshotHeader& header, size_t recordBytes, SnapshotReader& reader);
+// Loads a whole .dat file into tasks and titleArena. False if it is damaged.
+bool DecodeSnapshot(const unsigned char* data, size_t size);
+// A UTF-16LE text snapshot with a BOM, a "#TOFU 2 <nextId>" line, then one
+// "id|title|flag" line per task. It has no room for plans.
+void EncodeTextSnapshot(const TaskStore& list, unsigned long nextId, std::vector<unsigned char>& out);
+// Appends to tasks the tasks of the text snapshot held in titleArena from
+// `start` on and NUL-terminated; their titles are views into it.
+void ParseTextSnapshot(size_t start);
+
+// --- Scroll Animation ---
+// Scroll positions are 24.8 fixed-point rows: the soft-float ARM926 target
+// pays a libgcc call for every double operation, and 16.16 would not hold
+// the row numbers of very large lists. Times are millisecond ticks.
+#define FIX_SHIFT 8
+#define FIX_ONE (1 << FIX_SHIFT)
+#define INT_TO_FIX(i) ((long)(i) * FIX_ONE)
+#define FIX_FLOOR(f) ((int)((f) >> FIX_SHIFT))
+#define FIX_ROUND(f) FIX_FLOOR((f) + FIX_ONE / 2)
+
+extern long visualScrollPos; // Where the wheel is drawn
+extern long targetScrollPos; // Where it settles; always a whole row in [0, n)
+extern bool isAnimating;
+const int ANIM_DURATION = 350; // ms
+#define CARET_BLINK_MS 500 // The add-mode caret is shown for the first half of each second
+
+void SnapScroll(int row);
+void ScrollTowardRow(int row, unsigned long now);
+void ScrollTowardIndex(int index, unsigned long now);
+bool TickScroll(unsigned long now);
+
+// --- Drag & Flick ---
+// y is in client pixels. EndDrag returns false if the stylus never moved
+// past DRAG_SLOP, in which case the press was a tap for the caller.
+#define DRAG_SLOP 6
+#define FLICK_MIN_SPEED 2 // Rows per second; slower releases just settle
+#define FLICK_DECEL 40    // Rows per second squared
+#define FLICK_HOLD_MS 80  // A stylus still this long before lifting is not a flick
+#define FLICK_MAX_MS 2000
+
+bool IsDragging();
+void BeginDrag(int y, unsigned long now);
+bool DragTo(int y, unsigned long now);
+bool EndDrag(int y, unsigned long now);
+
+// --- Input ---
+// Each returns whether anything changed; the caller persists and repaints.
+int WrapIndex(int j, int n);
+bool StepSelection(int delta);
+bool ToggleTask(int index);
+bool EraseTask(int index);
+void BeginAddTask();
+bool EditSelectedTitle(wchar_t ch);
+void CommitAddTask();
+bool EndAddTask();
+int TapSlot(int y, int height);
+bool TapHitsIndicator(int x);
+int SlotToRow(int slot);
+
+// --- Undo ---
+// ToggleTask, EraseTask and a kept add are logged with just what it takes to
+// invert them, in a byte log of at most UNDO_LOG_BYTES; the oldest entries go
+// first. Undo and Redo apply one step and report the change made, as an
+// ordinary add, delete or toggle, for the caller to persist.
+#define UNDO_LOG_BYTES (16 * 1024)
+
+enum EditKind { EDIT_ADD, EDIT_DELETE, EDIT_TOGGLE };
+
+void ResetUndo();
+bool CanUndo();
+bool CanRedo();
+bool Undo(EditKind& applied, Task& task);
+bool Redo(EditKind& applied, Task& task);
+
+// --- Lists ---
+// The catalog names every list and keeps its size, completion count and next
+// id, so a list can be shown and switched to without loading it. Only the
+// active list is in tasks. Lists switched away from stay resident, least
+// recently used first out, while their estimated footprint fits in
+// LIST_CACHE_BYTES; a cold list is dropped as soon as it is left.
+#define LIST_CACHE_BYTES (256 * 1024)
+
+struct ListInfo {
+    std::wstring name;
+    unsigned long fileId; // Names the list's files; 0 is the original tasks.*
+    unsigned long count;
+    unsigned long completed;
+    unsigned long nextId; // Lets tasks be added to the list while it is not loaded
+    bool cold;
+};
+
+extern std::vector<ListInfo> lists;
+extern int activeList;
+
+const wchar_t* ActiveListName();
+int StepList(int delta);
+int FindColdList();
+void SummarizeActiveList();
+void ParkActiveList();
+bool RestoreList(unsigned long fileId);
+void TrimResidentLists(size_t budget);
+
+// --- Sync ---
+// Two copies of a list, such as the device's and the desktop build's, trade
+// only what changed since the other side last merged. A task's key is the
+// same in every copy, and its title, completion and deletion each carry a
+// Lamport stamp. A merge keeps the newer stamp per field, with ties going to
+// the larger value, and a delete always wins, so copies converge whatever
+// order deltas are merged in. Tasks already in the list when sync is enabled
+// are keyed by their title, so two copies of one list match up on the first
+// sync; later tasks are keyed by the replica that added them. Replica ids
+// have the top bit set, which no title key has. Sync is off until EnableSync.
+// Tombstones go once every known peer has merged them, so a third copy that
+// first syncs after that can miss those deletes.
+struct SyncStamp {
+    unsigned long clock; // 0: from before sync was enabled
+    unsigned long replica;
+};
+
+struct SyncKey {
+    unsigned long origin; // Adding replica, or the occurrence of a title
+    unsigned long serial; // Clock of the add, or the title hash
+};
+
+struct SyncEntry {
+    SyncKey key;
+    unsigned long id; // Local task id; a tombstone keeps the id it had
+    SyncStamp title;
+    SyncStamp completed;
+    SyncStamp deleted; // clock 0 while the task is alive
+};
+
+struct SyncPeer {
+    unsigned long replica;
+    unsigned long seen; // The peer's clock when it wrote the last delta merged here
+    unsigned long ack;  // syncClock here as of the last delta of ours the peer merged
+};
+
+// One task's state as exchanged; title and completion are meaningless once deleted.
+struct SyncRecord {
+    SyncKey key;
+    SyncStamp title;
+    SyncStamp completed;
+    SyncStamp deleted;
+    bool isCompleted;
+    std::wstring text;
+};
+
+enum SyncField { SYNC_ADD, SYNC_DELETE, SYNC_COMPLETED, SYNC_TITLE };
+
+struct SyncChange {
+    SyncField field;
+    Task task;
+};
+
+extern unsigned long syncReplica; // 0 while sync is off
+extern unsigned long syncClock;
+extern std::vector<SyncEntry> syncEntries; // Ascending id
+extern std::vector<SyncPeer> syncPeers;
+
+void ResetSync();
+void EnableSync(unsigned long replica);
+void ReconcileSync();
+void NoteSyncEdit(SyncField field, const Task& t);
+void CollectSyncDelta(std::vector<SyncRecord>& out);
+// `ack` is the sender's SyncPeer::seen for this replica. Merged changes are
+// applied to tasks and listed for the caller to persist, without stamps of
+// their own. Returns false if the delta was already merged.
+bool MergeSyncDelta(unsigned long from, unsigned long clock, unsigned long ack,
+                    const std::vector<SyncRecord>& in, std::vector<SyncChange>& changes);
+
+// --- Search ---
+// In MODE_SEARCH the wheel shows only the tasks whose title contains
+// searchQuery, case- and width-insensitively. While a search is active,
+// selectedIndex and the scroll position count rows of that view;
+// ViewToTask maps a view row to its position in tasks.
+extern std::wstring searchQuery;
+
+void IndexTask(const Task& t);
+void UnindexTask(const Task& t);
+void ResetSearchIndex();
+size_t ViewSize();
+int ViewToTask(int j);
+void BeginSearch();
+bool EditSearchQuery(wchar_t ch);
+void EndSearch(bool commit);
+
+// --- Views ---
+// Outside a search the wheel can show the list in another order without
+// moving anything in tasks: open tasks first, by due day or by priority,
+// with ties kept in list order. The order in use is an order-statistic treap
+// over (sort key, id), built when first needed and kept current by every
+// change, so a view row maps to a task and back in O(log n).
+enum ViewOrder { ORDER_LIST, ORDER_OPEN_FIRST, ORDER_DUE, ORDER_PRIORITY, ORDER_COUNT };
+
+extern ViewOrder viewOrder;
+
+const wchar_t* ViewOrderName(); // Empty in list order
+void SetViewOrder(ViewOrder order);
+void ViewTask(const Task& t);
+void UnviewTask(const Task& t);
+void ResetViewIndex();
+int TaskToView(int index);
+bool SetTaskPriority(int index, int priority);
+bool SetTaskDue(int index, unsigned short due);
+
+// --- Layout ---
+// Right and bottom edges are exclusive.
+struct LayoutRect {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+LayoutRect MakeLayoutRect(int left, int top, int right, int bottom);
+bool RectsOverlap(const LayoutRect& a, const LayoutRect& b);
+LayoutRect GetHeaderRect(int width, int height);
+LayoutRect GetFooterRect(int width, int height);
+LayoutRect GetRowRect(int width, int height, int slot);
+int GetRowAlpha(int distFromCenter, int centerY);
+
+// --- Frame Commands ---
+// EmitFrame walks the visible rows for the current scroll position and calls
+// the sink once per primitive that touches the dirty rect, back to front.
+
+class FrameSink {
+public:
+    virtual ~FrameSink() {}
+    virtual void Background(const LayoutRect& r) = 0;
+    virtual void FocusFrame(const LayoutRect& r, bool editing) = 0;
+    virtual void Seam(int left, int right, int y) = 0;
+    virtual void Indicator(const LayoutRect& itemRect, bool completed) = 0;
+    // alpha is 0..255. The row being typed into changes every keystroke;
+    // editing tells the sink not to cache it.
+    virtual void RowTitle(const LayoutRect& textRect, const Task& t, int alpha, bool editing, bool caret) = 0;
+    virtual void Header(const LayoutRect& r, AppMode mode, const wchar_t* query, const wchar_t* listName) = 0;
+    virtual void Footer(const LayoutRect& r, AppMode mode, size_t count) = 0;
+};
+
+struct FrameStats {
+    int rowsVisited; // Rows walked by the layout loop
+    int commands;    // Sink calls made
+};
+
+FrameStats EmitFrame(FrameSink& sink, int width, int height, const LayoutRect& dirty, unsigned long now);
+
+#endif
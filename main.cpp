@@ -13,9 +13,11 @@
 
 #include <windows.h>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <string>
 #include <ctime>
-#include <math.h>
+#include <stdlib.h>
 #include <stdio.h>
 
 // --- Windows CE Boilerplate ---
@@ -35,13 +37,8 @@
 #endif
 
 #include <tchar.h>
-
-// --- Design Constants (8pt Grid) ---
-#define GRID_UNIT 8
-#define MARGIN_X (GRID_UNIT * 3) // 24pt
-#define MARGIN_Y (GRID_UNIT * 4) // 32pt
-#define ITEM_HEIGHT (GRID_UNIT * 6) // 48pt
-#define CORNER_RADIUS GRID_UNIT
+#include "core.h"
+#include "canvas.h"
 
 // Colors
 #define CLR_BG          RGB(0, 0, 0)
@@ -50,32 +47,227 @@
 #define CLR_ACCENT      RGB(255, 255, 255)
 #define CLR_GLASS_BORDER RGB(60, 60, 60)
 
-struct Task {
-    std::wstring title;
-    bool completed;
-    Task() : title(L""), completed(false) {}
-    Task(const std::wstring& t) : title(t), completed(false) {}
-};
-
-enum AppMode { MODE_LIST, MODE_ADD };
-
 // Globals
-std::vector<Task> tasks;
-int selectedIndex = 0;
-AppMode currentMode = MODE_LIST;
 RECT clientRect;
 HFONT hFontMain = NULL;
 HFONT hFontDot = NULL;
 
-// --- Animation Globals ---
-double visualScrollPos = 0.0;
-double targetScrollPos = 0.0;
-double startScrollPos = 0.0;
-DWORD animStartTime = 0;
-const int ANIM_DURATION = 350; // ms
-bool isAnimating = false;
+// --- Performance Trace ---
+// A fixed ring of timestamped events from the UI thread and the journal
+// writer. Recording takes no lock: a slot is claimed with one interlocked
+// increment, so a reader racing a writer at worst sees one stale event.
+// Times are microseconds from the performance counter. The ring is read
+// only by the HUD, when it is shown, and by the dump on exit.
+
+#define PERF_RING_SIZE 1024 // Power of two
+#define PERF_HUD_TIMER 3
+#define PERF_HUD_MS 500
+#define PERF_HUD_FRAMES 128 // Frame times behind p50 and p99
+
+enum PerfKind { PERF_FRAME_START, PERF_FRAME_END, PERF_TIMER, PERF_SAVE, PERF_FOLD, PERF_GDI, PERF_WAKE, PERF_KIND_COUNT };
+
+struct PerfEvent {
+    DWORD time;
+    DWORD value; // Duration or interval in microseconds; a count for PERF_GDI, 0 for PERF_WAKE
+    DWORD kind;
+};
+
+PerfEvent perfRing[PERF_RING_SIZE];
+volatile LONG perfCount = 0; // Events ever recorded
+LONGLONG perfFrequency = 0;  // 0 if there is no performance counter
+DWORD perfLastTimer = 0;
+bool perfHudVisible = false;
+
+void InitPerf() {
+    LARGE_INTEGER f;
+    if (QueryPerformanceFrequency(&f) && f.QuadPart > 0) perfFrequency = f.QuadPart;
+}
+
+DWORD PerfNow() {
+    LARGE_INTEGER c;
+    if (!perfFrequency || !QueryPerformanceCounter(&c)) return GetTickCount() * 1000;
+    return (DWORD)(c.QuadPart / perfFrequency * 1000000 + c.QuadPart % perfFrequency * 1000000 / perfFrequency);
+}
+
+void PerfRecord(PerfKind kind, DWORD value) {
+    LONG n = InterlockedIncrement(&perfCount) - 1;
+    PerfEvent& e = perfRing[n & (PERF_RING_SIZE - 1)];
+    e.time = PerfNow();
+    e.value = value;
+    e.kind = kind;
+}
+
+// --- Frame Scheduler ---
+// The core advances the wheel and blinks the caret; the window asks for a
+// wakeup only while one of them needs a frame. Each wakeup arms one timer for
+// the earliest deadline, measured from the tick it actually arrived on, so a
+// late WM_TIMER does not push later frames back, and frames it missed are
+// skipped rather than drawn in a burst. With the wheel still and no caret
+// there is no timer at all.
+
+#define FRAME_TIMER 1
+#define FRAME_MS 16 // ~60fps
+
+bool framesRunning = false; // The wheel's frame grid is live
+DWORD nextFrameDue = 0;     // Ticks
+DWORD nextCaretDue = 0;
+
+void InvalidateCaret(HWND hWnd);
+
+bool TickDue(DWORD now, DWORD due) {
+    return (LONG)(now - due) >= 0;
+}
+
+// Arms the timer for the earliest deadline, or kills it if nothing is due.
+void ScheduleFrames(HWND hWnd) {
+    if (!isAnimating) framesRunning = false;
+    bool caret = currentMode == MODE_ADD;
+    if (!framesRunning && !caret) {
+        KillTimer(hWnd, FRAME_TIMER);
+        return;
+    }
+    DWORD due = framesRunning ? nextFrameDue : nextCaretDue;
+    if (framesRunning && caret && TickDue(due, nextCaretDue)) due = nextCaretDue;
+    LONG wait = (LONG)(due - GetTickCount());
+    SetTimer(hWnd, FRAME_TIMER, wait > 0 ? (UINT)wait : 1, NULL);
+}
+
+// Starts frames for a wheel the core has just set moving; one already
+// moving keeps its grid.
+void RequestFrames(HWND hWnd) {
+    if (isAnimating && !framesRunning) {
+        framesRunning = true;
+        nextFrameDue = GetTickCount() + FRAME_MS;
+    }
+    ScheduleFrames(hWnd);
+}
+
+// Caret deadlines fall on the blink phase the core draws from.
+void RequestCaret(HWND hWnd) {
+    nextCaretDue = (GetTickCount() / CARET_BLINK_MS + 1) * CARET_BLINK_MS;
+    ScheduleFrames(hWnd);
+}
+
+void OnFrameTimer(HWND hWnd) {
+    DWORD now = GetTickCount();
+    PerfRecord(PERF_WAKE, 0);
+    if (framesRunning && TickDue(now, nextFrameDue)) {
+        DWORD tick = PerfNow();
+        if (tick - perfLastTimer < 1000000) PerfRecord(PERF_TIMER, tick - perfLastTimer); // Skip the first after idle
+        perfLastTimer = tick;
+        TickScroll(now);
+        InvalidateRect(hWnd, NULL, FALSE);
+        nextFrameDue += FRAME_MS;
+        if (TickDue(now, nextFrameDue)) nextFrameDue += ((now - nextFrameDue) / FRAME_MS + 1) * FRAME_MS;
+    }
+    if (currentMode == MODE_ADD && TickDue(now, nextCaretDue)) {
+        InvalidateCaret(hWnd);
+        nextCaretDue = (now / CARET_BLINK_MS + 1) * CARET_BLINK_MS;
+    }
+    ScheduleFrames(hWnd);
+}
+
+void ScrollToRow(int row, HWND hWnd) {
+    ScrollTowardRow(row, GetTickCount());
+    RequestFrames(hWnd);
+}
+
+void StartScrollAnimation(int newIdx, HWND hWnd) {
+    if (ViewSize() == 0) return;
+    ScrollTowardIndex(newIdx, GetTickCount());
+    RequestFrames(hWnd);
+}
+
+// Repeats of `key` that queued up behind a slow frame, taken off the queue
+// so the wheel is retargeted once for all of them.
+int TakeQueuedRepeats(HWND hWnd, WPARAM key) {
+    MSG msg;
+    int taken = 0;
+    while (PeekMessage(&msg, hWnd, WM_KEYFIRST, WM_KEYLAST, PM_NOREMOVE) &&
+           msg.message == WM_KEYDOWN && msg.wParam == key) {
+        PeekMessage(&msg, hWnd, WM_KEYFIRST, WM_KEYLAST, PM_REMOVE);
+        ++taken;
+    }
+    return taken;
+}
+
+void StepScroll(int direction, WPARAM key, HWND hWnd) {
+    int steps = 1 + TakeQueuedRepeats(hWnd, key);
+    if (StepSelection(direction * steps)) StartScrollAnimation(selectedIndex, hWnd);
+}
+
+int pressX = 0; // Where the stylus went down, for a press that turns out to be a tap
+int pressY = 0;
 
 // --- Persistence ---
+// tasks.dat is a snapshot and tasks.log an append-only journal of the mutations
+// made since. Records assign state rather than flip it, so replaying a journal
+// over a snapshot that already contains it is harmless. Each list has its own
+// pair, named by its file id (tasks.* for list 0, list<id>.* for the rest);
+// lists.dat is the catalog.
+//
+// After load, no file I/O happens on the UI thread. Records are queued in
+// journalQueue and written by a writer thread once JOURNAL_IDLE_MS pass
+// without a new one (JOURNAL_MAX_DELAY_MS at most), so a burst of toggles
+// costs one write. The writer also rotates the journal and folds it into a
+// snapshot, from a copy of the list taken on the UI thread, and writes the
+// batches ArchiveCompleted encodes there.
+
+#define JOURNAL_COMPACT_BYTES (32 * 1024)
+#define JOURNAL_IDLE_MS 250
+#define JOURNAL_MAX_DELAY_MS 2000
+#define CATALOG_MAGIC 0x534C4654 // "TFLS"
+#define CATALOG_VERSION 1
+
+// lists.dat: header, then per list a CatalogRecord followed by its name.
+struct CatalogHeader {
+    DWORD magic;
+    WORD version;
+    WORD activeList;
+    DWORD count;
+    DWORD crc; // CRC-32 of everything after the header
+};
+
+struct CatalogRecord {
+    DWORD fileId;
+    DWORD count;
+    DWORD completed;
+    DWORD nextId;
+    WORD nameLen;
+    WORD flags;
+};
+
+#define CATALOG_COLD 0x0001
+
+struct CompactJob {
+    std::wstring base; // Directory and file stem of the list
+    TaskStore tasks;
+    DWORD nextId;
+    std::vector<BYTE> records; // Queued before the copy; they belong in the rotated log
+};
+
+// Completed tasks moved to the cold list, encoded on the UI thread.
+struct ArchiveJob {
+    std::wstring base;         // Directory and file stem of the cold list
+    std::vector<BYTE> catalog; // lists.dat with the cold list's ids taken, saved first
+    std::vector<BYTE> adds;    // For the cold list's journal, flushed before the deletes
+    std::vector<BYTE> records; // For the active journal: the queue at the time, then the deletes
+    size_t queued;             // Bytes of records ahead of the deletes
+};
+
+std::wstring listBase; // Directory and file stem of the active list
+HANDLE hJournal = INVALID_HANDLE_VALUE; // Used by the writer thread while it runs
+DWORD journalBytes = 0; // Queued since the last compaction; UI thread only
+
+CRITICAL_SECTION journalLock; // Guards journalQueue, compactJob and archiveJob
+std::vector<BYTE> journalQueue;
+CompactJob* compactJob = NULL;
+ArchiveJob* archiveJob = NULL;
+volatile LONG compactBusy = 0; // From a compaction request until its fold is done
+volatile LONG archiveBusy = 0; // From an archive request until its deletes are written; kept if it fails
+volatile LONG writerStop = 0;
+HANDLE hWriterEvent = NULL; // Auto-reset: records, a compaction or stop
+HANDLE hWriterThread = NULL;
 
 std::wstring GetAppDir() {
     wchar_t path[MAX_PATH];
@@ -88,64 +280,982 @@ std::wstring GetAppDir() {
     return L"";
 }
 
-void SaveTasks() {
-    std::wstring path = GetAppDir() + L"tasks.txt";
+std::wstring GetListBase(unsigned long fileId) {
+    if (fileId == 0) return GetAppDir() + L"tasks";
+    TCHAR stem[16];
+    wsprintf(stem, TEXT("list%lu"), fileId);
+    return GetAppDir() + stem;
+}
+
+bool FileExists(const std::wstring& path) {
+    return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+// Writes `data` to tmpPath and moves it over path once it is on the card.
+bool WriteWholeFile(const std::wstring& path, const std::wstring& tmpPath, const std::vector<BYTE>& data) {
+    HANDLE hFile = CreateFileW(tmpPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    BOOL ok = WriteFile(hFile, &data[0], (DWORD)data.size(), &written, NULL);
+    ok = FlushFileBuffers(hFile) && ok;
+    CloseHandle(hFile);
+    if (!ok || written != data.size()) return false;
+    DeleteFileW(path.c_str());
+    return MoveFileW(tmpPath.c_str(), path.c_str()) != 0;
+}
+
+bool ReadWholeFile(const std::wstring& path, std::vector<BYTE>& data) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    DWORD fileSize = GetFileSize(hFile, NULL);
+    data.resize(fileSize + 1);
+    DWORD read = 0;
+    BOOL ok = ReadFile(hFile, &data[0], fileSize, &read, NULL);
+    CloseHandle(hFile);
+    data.resize(read);
+    return ok && read == fileSize;
+}
+
+bool WriteSnapshot(const std::wstring& path, const TaskStore& list, DWORD nextId) {
     HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) return;
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+
+    std::vector<BYTE> data;
+    EncodeSnapshot(list, nextId, data);
+    DWORD bytes = (DWORD)data.size();
+    DWORD written = 0;
+    BOOL ok = WriteFile(hFile, &data[0], bytes, &written, NULL);
+    ok = FlushFileBuffers(hFile) && ok; // On the card before it replaces tasks.dat
+    CloseHandle(hFile);
+    return ok && written == bytes;
+}
 
-    // Write UTF-16LE BOM
-    unsigned short bom = 0xFEFF;
-    DWORD written;
-    WriteFile(hFile, &bom, 2, &written, NULL);
+// Writes list as the new .dat and retires the rotated journal it contains.
+bool FoldSnapshot(const std::wstring& base, const TaskStore& list, DWORD nextId) {
+    std::wstring tmpPath = base + L".tmp";
+    std::wstring snapPath = base + L".dat";
+    if (!WriteSnapshot(tmpPath, list, nextId)) return false;
+    DeleteFileW(snapPath.c_str());
+    if (!MoveFileW(tmpPath.c_str(), snapPath.c_str())) return false;
+    DeleteFileW((base + L".old").c_str());
+    return true;
+}
 
-    for (size_t i = 0; i < tasks.size(); ++i) {
-        std::wstring line = tasks[i].title + L"|" + (tasks[i].completed ? L"1" : L"0") + L"\r\n";
-        WriteFile(hFile, line.c_str(), (DWORD)(line.length() * sizeof(wchar_t)), &written, NULL);
+HANDLE OpenJournalFile(const std::wstring& base) {
+    HANDLE h = CreateFileW((base + L".log").c_str(), GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h != INVALID_HANDLE_VALUE) SetFilePointer(h, 0, NULL, FILE_END);
+    return h;
+}
+
+void OpenJournal(const std::wstring& base) {
+    hJournal = OpenJournalFile(base);
+    journalBytes = (hJournal != INVALID_HANDLE_VALUE) ? GetFileSize(hJournal, NULL) : 0;
+}
+
+// One WriteFile per batch: a crash leaves at most one torn record at the
+// tail, which replay cuts off.
+void WriteJournalBatch(const std::vector<BYTE>& batch) {
+    if (batch.empty() || hJournal == INVALID_HANDLE_VALUE) return;
+    DWORD start = PerfNow();
+    DWORD written = 0;
+    WriteFile(hJournal, &batch[0], (DWORD)batch.size(), &written, NULL);
+    PerfRecord(PERF_SAVE, PerfNow() - start);
+}
+
+void FlushJournalQueue() {
+    std::vector<BYTE> batch;
+    EnterCriticalSection(&journalLock);
+    batch.swap(journalQueue);
+    LeaveCriticalSection(&journalLock);
+    WriteJournalBatch(batch);
+}
+
+// Finishes tasks.log with the records job's list already contains, rotates
+// it to tasks.old and folds it into a snapshot of that list.
+void RunCompaction(CompactJob* job) {
+    WriteJournalBatch(job->records);
+    std::wstring oldPath = job->base + L".old";
+    if (!FileExists(oldPath)) { // A failed fold is retried by the next LoadTasks()
+        CloseHandle(hJournal);
+        BOOL rotated = MoveFileW((job->base + L".log").c_str(), oldPath.c_str());
+        hJournal = OpenJournalFile(job->base);
+        DWORD start = PerfNow();
+        if (rotated && FoldSnapshot(job->base, job->tasks, job->nextId)) PerfRecord(PERF_FOLD, PerfNow() - start);
     }
+    delete job;
+}
+
+// The catalog goes first so the cold list's ids are never handed out twice,
+// and the deletes last so a task is never in neither list. If the cold list
+// cannot be opened the deletes are dropped: the tasks come back next start.
+bool RunArchive(ArchiveJob* job) {
+    HANDLE hArchive = OpenJournalFile(job->base);
+    bool ok = hArchive != INVALID_HANDLE_VALUE;
+    if (ok) {
+        WriteWholeFile(GetAppDir() + L"lists.dat", GetAppDir() + L"lists.tmp", job->catalog);
+        DWORD written = 0;
+        WriteFile(hArchive, &job->adds[0], (DWORD)job->adds.size(), &written, NULL);
+        FlushFileBuffers(hArchive);
+        CloseHandle(hArchive);
+    } else {
+        job->records.resize(job->queued);
+    }
+    WriteJournalBatch(job->records);
+    delete job;
+    return ok;
+}
+
+DWORD WINAPI JournalWriterProc(LPVOID param) {
+    UNREFERENCED_PARAMETER(param);
+    for (;;) {
+        WaitForSingleObject(hWriterEvent, INFINITE);
+        // Coalesce a burst: wait for a quiet spell before touching the card
+        DWORD start = GetTickCount();
+        while (!writerStop && GetTickCount() - start < JOURNAL_MAX_DELAY_MS &&
+               WaitForSingleObject(hWriterEvent, JOURNAL_IDLE_MS) == WAIT_OBJECT_0) {
+        }
+
+        EnterCriticalSection(&journalLock);
+        CompactJob* job = compactJob;
+        compactJob = NULL;
+        LeaveCriticalSection(&journalLock);
+
+        if (job) {
+            RunCompaction(job);
+            InterlockedExchange(&compactBusy, 0);
+        }
+        // After any compaction, which was posted first: its copy has the tasks
+        EnterCriticalSection(&journalLock);
+        ArchiveJob* archive = archiveJob;
+        archiveJob = NULL;
+        LeaveCriticalSection(&journalLock);
+        if (archive && RunArchive(archive)) InterlockedExchange(&archiveBusy, 0);
+        FlushJournalQueue(); // Records made after the copy go to the new log
+        if (writerStop) return 0;
+    }
+}
+
+void InitJournalWriter() {
+    InitializeCriticalSection(&journalLock);
+}
+
+void StartJournalWriter() {
+    writerStop = 0;
+    hWriterEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (hWriterEvent) hWriterThread = CreateThread(NULL, 0, JournalWriterProc, NULL, 0, NULL);
+}
+
+bool IsCompacting() {
+    return compactBusy != 0;
+}
+
+// Hands the writer a copy of the list to fold once tasks.log is rotated. The
+// list must already include every queued record, so changes are journaled
+// after they are made.
+void CompactJournal() {
+    // Not past an archive not yet on the card: the fold would drop its tasks
+    // from this list before the cold list had them
+    if (IsCompacting() || archiveBusy) return;
+    CompactJob* job = new CompactJob;
+    job->base = listBase;
+    job->tasks = tasks;
+    job->nextId = nextTaskId;
+    journalBytes = 0;
+    EnterCriticalSection(&journalLock);
+    job->records.swap(journalQueue);
+    LeaveCriticalSection(&journalLock);
+    if (!hWriterThread) {
+        RunCompaction(job);
+        return;
+    }
+    InterlockedExchange(&compactBusy, 1);
+    EnterCriticalSection(&journalLock);
+    compactJob = job;
+    LeaveCriticalSection(&journalLock);
+    SetEvent(hWriterEvent);
+}
+
+// Stops the writer after it has written everything queued.
+void CloseJournal() {
+    if (hWriterThread) {
+        InterlockedExchange(&writerStop, 1);
+        SetEvent(hWriterEvent);
+        WaitForSingleObject(hWriterThread, INFINITE);
+        CloseHandle(hWriterThread);
+        hWriterThread = NULL;
+    }
+    if (hWriterEvent) {
+        CloseHandle(hWriterEvent);
+        hWriterEvent = NULL;
+    }
+    if (compactJob) {
+        RunCompaction(compactJob);
+        compactJob = NULL;
+    }
+    compactBusy = 0;
+    if (archiveJob) {
+        if (RunArchive(archiveJob)) archiveBusy = 0;
+        archiveJob = NULL;
+    }
+    FlushJournalQueue();
+    if (hJournal != INVALID_HANDLE_VALUE) {
+        CloseHandle(hJournal);
+        hJournal = INVALID_HANDLE_VALUE;
+    }
+}
+
+// Has the writer write everything queued so far, and waits for it.
+void FlushJournal() {
+    CloseJournal();
+    OpenJournal(listBase);
+    StartJournalWriter();
+}
+
+// Queues a record for the writer thread; never blocks on the card.
+void QueueJournal(BYTE op, const Task& t) {
+    std::vector<BYTE> buf;
+    EncodeJournalRecord(op, t, buf);
+
+    EnterCriticalSection(&journalLock);
+    journalQueue.insert(journalQueue.end(), buf.begin(), buf.end());
+    LeaveCriticalSection(&journalLock);
+    if (hWriterThread) SetEvent(hWriterEvent);
+    else FlushJournalQueue();
+
+    journalBytes += (DWORD)buf.size();
+    if (journalBytes >= JOURNAL_COMPACT_BYTES) CompactJournal();
+}
+
+// Journals a change made on this copy, stamping it for sync.
+void AppendJournal(BYTE op, const Task& t) {
+    if (op == JOP_ADD) NoteSyncEdit(SYNC_ADD, t);
+    else if (op == JOP_DELETE) NoteSyncEdit(SYNC_DELETE, t);
+    else if (op == JOP_SET_COMPLETED) NoteSyncEdit(SYNC_COMPLETED, t);
+    else if (op == JOP_SET_TITLE) NoteSyncEdit(SYNC_TITLE, t);
+    QueueJournal(op, t);
+}
+
+bool TaskIdLess(const Task& a, const Task& b) {
+    return a.id < b.id;
+}
+
+// Returns false if the journal does not exist. A torn or corrupt tail is cut off.
+bool ReplayJournal(const std::wstring& path, std::map<unsigned long, size_t>& index) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+
+    DWORD fileSize = GetFileSize(hFile, NULL);
+    BYTE* buffer = new BYTE[fileSize + 1];
+    DWORD read = 0;
+    ReadFile(hFile, buffer, fileSize, &read, NULL);
+
+    DWORD pos = (DWORD)ReplayJournalRecords(buffer, read, index);
+    if (pos < read) {
+        SetFilePointer(hFile, (LONG)pos, NULL, FILE_BEGIN);
+        SetEndOfFile(hFile);
+    }
+    delete[] buffer;
     CloseHandle(hFile);
+    return true;
 }
 
-void LoadTasks() {
-    std::wstring path = GetAppDir() + L"tasks.txt";
-    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
-        // Default tasks
-        tasks.push_back(Task(L"Eat Tofu"));
-        tasks.push_back(Task(L"Stay Mental"));
-        tasks.push_back(Task(L"Build PW-SH2 Apps"));
+// --- Sync Files ---
+// A copy's sync state for a list is kept in <base>.sy. Deltas travel as plain
+// files: each copy writes <base>-<replica>.syd next to its lists, and merges
+// every other .syd it finds there, so syncing with the desktop build is a
+// matter of copying the two files across on the SD card. A delta is rewritten
+// whole each time with everything the other side has not yet confirmed, so
+// missing one never loses a change.
+
+#define SYNC_STATE_MAGIC 0x59534654 // "TFSY"
+#define SYNC_DELTA_MAGIC 0x44534654 // "TFSD"
+#define SYNC_VERSION 1
+#define SYNC_DELTA_COMPLETED 0x0001
+
+struct SyncStateHeader {
+    DWORD magic;
+    WORD version;
+    WORD reserved;
+    DWORD replica;
+    DWORD clock;
+    DWORD entryCount; // SyncEntry's, then SyncPeer's
+    DWORD peerCount;
+    DWORD crc; // CRC-32 of everything after the header
+};
+
+// .syd: header, peerCount SyncDeltaPeer's, then per task a SyncDeltaRecord
+// followed by its title.
+struct SyncDeltaHeader {
+    DWORD magic;
+    WORD version;
+    WORD reserved;
+    DWORD replica;
+    DWORD clock;
+    DWORD peerCount;
+    DWORD recordCount;
+    DWORD crc;
+};
+
+struct SyncDeltaPeer {
+    DWORD replica;
+    DWORD seen;
+};
+
+struct SyncDeltaRecord {
+    DWORD origin;
+    DWORD serial;
+    DWORD titleClock;
+    DWORD titleReplica;
+    DWORD completedClock;
+    DWORD completedReplica;
+    DWORD deletedClock;
+    DWORD deletedReplica;
+    WORD flags;
+    WORD titleLen;
+};
+
+// Random enough that two copies never pick the same id; the top bit marks it
+// as a replica rather than a title key.
+DWORD NewSyncReplica() {
+    SYSTEMTIME st;
+    GetSystemTime(&st);
+    DWORD mix[3];
+    mix[0] = GetTickCount();
+    mix[1] = PerfNow();
+    mix[2] = (DWORD)(size_t)&st;
+    DWORD h = JournalChecksum((const BYTE*)&st, sizeof(st));
+    h ^= JournalChecksum((const BYTE*)mix, sizeof(mix));
+    return h | 0x80000000u;
+}
+
+std::wstring GetSyncDeltaPath(DWORD replica) {
+    TCHAR suffix[16];
+    wsprintf(suffix, TEXT("-%08lX.syd"), replica);
+    return listBase + suffix;
+}
+
+// The list's entries are only worth a write once sync is on.
+void SaveSyncState() {
+    if (!syncReplica) return;
+    size_t entryBytes = syncEntries.size() * sizeof(SyncEntry);
+    size_t peerBytes = syncPeers.size() * sizeof(SyncPeer);
+    std::vector<BYTE> data(sizeof(SyncStateHeader) + entryBytes + peerBytes);
+    if (entryBytes) memcpy(&data[sizeof(SyncStateHeader)], &syncEntries[0], entryBytes);
+    if (peerBytes) memcpy(&data[sizeof(SyncStateHeader) + entryBytes], &syncPeers[0], peerBytes);
+
+    SyncStateHeader header;
+    header.magic = SYNC_STATE_MAGIC;
+    header.version = SYNC_VERSION;
+    header.reserved = 0;
+    header.replica = syncReplica;
+    header.clock = syncClock;
+    header.entryCount = (DWORD)syncEntries.size();
+    header.peerCount = (DWORD)syncPeers.size();
+    header.crc = Crc32(&data[sizeof(header)], (DWORD)(entryBytes + peerBytes));
+    memcpy(&data[0], &header, sizeof(header));
+    WriteWholeFile(listBase + L".sy", listBase + L".syt", data);
+}
+
+// Loads the active list's sync state, if it has one, once tasks is complete.
+void LoadSyncState() {
+    ResetSync();
+    std::vector<BYTE> data;
+    if (!ReadWholeFile(listBase + L".sy", data) || data.size() < sizeof(SyncStateHeader)) return;
+    SyncStateHeader header;
+    memcpy(&header, &data[0], sizeof(header));
+    size_t entryBytes = header.entryCount * sizeof(SyncEntry);
+    size_t peerBytes = header.peerCount * sizeof(SyncPeer);
+    if (header.magic != SYNC_STATE_MAGIC || header.version != SYNC_VERSION ||
+        data.size() != sizeof(header) + entryBytes + peerBytes ||
+        Crc32(&data[sizeof(header)], (DWORD)(entryBytes + peerBytes)) != header.crc) {
+        return; // Sync starts over as a first sync, which is a union of both copies
+    }
+    syncReplica = header.replica;
+    syncClock = header.clock;
+    syncEntries.resize(header.entryCount);
+    syncPeers.resize(header.peerCount);
+    if (entryBytes) memcpy(&syncEntries[0], &data[sizeof(header)], entryBytes);
+    if (peerBytes) memcpy(&syncPeers[0], &data[sizeof(header) + entryBytes], peerBytes);
+    ReconcileSync();
+}
+
+void WriteSyncDelta() {
+    std::vector<SyncRecord> records;
+    CollectSyncDelta(records);
+    std::vector<BYTE> data(sizeof(SyncDeltaHeader));
+    for (size_t i = 0; i < syncPeers.size(); ++i) {
+        SyncDeltaPeer peer;
+        peer.replica = syncPeers[i].replica;
+        peer.seen = syncPeers[i].seen;
+        size_t at = data.size();
+        data.resize(at + sizeof(peer));
+        memcpy(&data[at], &peer, sizeof(peer));
+    }
+    for (size_t i = 0; i < records.size(); ++i) {
+        const SyncRecord& r = records[i];
+        SyncDeltaRecord rec;
+        rec.origin = r.key.origin;
+        rec.serial = r.key.serial;
+        rec.titleClock = r.title.clock;
+        rec.titleReplica = r.title.replica;
+        rec.completedClock = r.completed.clock;
+        rec.completedReplica = r.completed.replica;
+        rec.deletedClock = r.deleted.clock;
+        rec.deletedReplica = r.deleted.replica;
+        rec.flags = r.isCompleted ? SYNC_DELTA_COMPLETED : 0;
+        rec.titleLen = (WORD)(r.text.size() > 0xFFFF ? 0xFFFF : r.text.size());
+        size_t at = data.size();
+        data.resize(at + sizeof(rec) + rec.titleLen * sizeof(wchar_t));
+        memcpy(&data[at], &rec, sizeof(rec));
+        if (rec.titleLen) memcpy(&data[at + sizeof(rec)], r.text.c_str(), rec.titleLen * sizeof(wchar_t));
+    }
+
+    SyncDeltaHeader header;
+    header.magic = SYNC_DELTA_MAGIC;
+    header.version = SYNC_VERSION;
+    header.reserved = 0;
+    header.replica = syncReplica;
+    header.clock = syncClock;
+    header.peerCount = (DWORD)syncPeers.size();
+    header.recordCount = (DWORD)records.size();
+    header.crc = Crc32(&data[sizeof(header)], (DWORD)(data.size() - sizeof(header)));
+    memcpy(&data[0], &header, sizeof(header));
+    std::wstring path = GetSyncDeltaPath(syncReplica);
+    WriteWholeFile(path, path + L".tmp", data);
+}
+
+// Merges one .syd; a damaged or half-copied file is left for the next sync.
+void ReadSyncDelta(const std::wstring& path, std::vector<SyncChange>& changes) {
+    std::vector<BYTE> data;
+    if (!ReadWholeFile(path, data) || data.size() < sizeof(SyncDeltaHeader)) return;
+    SyncDeltaHeader header;
+    memcpy(&header, &data[0], sizeof(header));
+    if (header.magic != SYNC_DELTA_MAGIC || header.version != SYNC_VERSION ||
+        Crc32(&data[sizeof(header)], (DWORD)(data.size() - sizeof(header))) != header.crc) {
         return;
     }
 
+    size_t pos = sizeof(header);
+    DWORD ack = 0;
+    for (DWORD i = 0; i < header.peerCount; ++i) {
+        SyncDeltaPeer peer;
+        if (data.size() - pos < sizeof(peer)) return;
+        memcpy(&peer, &data[pos], sizeof(peer));
+        pos += sizeof(peer);
+        if (peer.replica == syncReplica) ack = peer.seen;
+    }
+    std::vector<SyncRecord> records(header.recordCount);
+    for (DWORD i = 0; i < header.recordCount; ++i) {
+        SyncDeltaRecord rec;
+        if (data.size() - pos < sizeof(rec)) return;
+        memcpy(&rec, &data[pos], sizeof(rec));
+        pos += sizeof(rec);
+        if ((data.size() - pos) / sizeof(wchar_t) < rec.titleLen) return;
+        SyncRecord& r = records[i];
+        r.key.origin = rec.origin;
+        r.key.serial = rec.serial;
+        r.title.clock = rec.titleClock;
+        r.title.replica = rec.titleReplica;
+        r.completed.clock = rec.completedClock;
+        r.completed.replica = rec.completedReplica;
+        r.deleted.clock = rec.deletedClock;
+        r.deleted.replica = rec.deletedReplica;
+        r.isCompleted = (rec.flags & SYNC_DELTA_COMPLETED) != 0;
+        r.text.assign((const wchar_t*)&data[pos], rec.titleLen);
+        pos += rec.titleLen * sizeof(wchar_t);
+    }
+    MergeSyncDelta(header.replica, header.clock, ack, records, changes);
+}
+
+// Merges the other copies' deltas into the active list, journals what they
+// changed, then writes this copy's delta. The first sync of a list enables
+// sync for it. Returns whether tasks changed.
+bool RunSync() {
+    if (!syncReplica) EnableSync(NewSyncReplica());
+    std::vector<SyncChange> changes;
+    std::wstring own = GetSyncDeltaPath(syncReplica);
+    std::wstring dir = GetAppDir();
+    WIN32_FIND_DATAW found;
+    HANDLE hFind = FindFirstFileW((listBase + L"-*.syd").c_str(), &found);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            std::wstring path = dir + found.cFileName;
+            if (path != own) ReadSyncDelta(path, changes);
+        } while (FindNextFileW(hFind, &found));
+        FindClose(hFind);
+    }
+
+    // Not AppendJournal: the changes keep the stamps they came with
+    for (size_t i = 0; i < changes.size(); ++i) {
+        const SyncChange& c = changes[i];
+        BYTE op = c.field == SYNC_ADD ? JOP_ADD : c.field == SYNC_DELETE ? JOP_DELETE :
+                  c.field == SYNC_COMPLETED ? JOP_SET_COMPLETED : JOP_SET_TITLE;
+        QueueJournal(op, c.task);
+    }
+    if (!changes.empty()) ResetUndo(); // Logged positions no longer hold
+    // The merged changes must be on the card before the state that says they were merged
+    FlushJournal();
+    WriteSyncDelta();
+    SaveSyncState();
+    return !changes.empty();
+}
+
+// --- Progressive Load ---
+// At start-up the first frame is drawn from a preview: the snapshot's first
+// and last LOAD_PREVIEW_ROWS records, which are all the wheel shows around
+// row 0, fetched with four small reads. The file is then read into
+// titleArena and its records built into a separate store in slices of
+// LOAD_SLICE_MS from a timer, and swapped in once the checksum holds. The
+// journal is replayed after that, so the preview is the list as of the last
+// fold. A list switched to is loaded the same way, in one go.
+
+#define LOAD_READ_BYTES (32 * 1024)
+#define LOAD_SLICE_MS 20
+#define LOAD_TIMER 2
+
+struct SnapshotLoad {
+    HANDLE hFile;
+    SnapshotHeader header;
+    DWORD fileSize;
+    DWORD read;  // Bytes of the file in titleArena so far
+    DWORD crc;   // Running CRC-32 of those after the header
+    bool verified;
+    DWORD built; // Records turned into tasks
+    DWORD recordBytes; // Per record: version 3 files lack the plan fields
+    TaskStore tasks;
+};
+
+SnapshotLoad* snapshotLoad = NULL; // Set while the preview is up
+
+bool IsLoadingTasks() {
+    return snapshotLoad != NULL;
+}
+
+bool ReadAt(HANDLE hFile, DWORD offset, void* buffer, DWORD bytes) {
+    DWORD read = 0;
+    SetFilePointer(hFile, (LONG)offset, NULL, FILE_BEGIN);
+    return ReadFile(hFile, buffer, bytes, &read, NULL) && read == bytes;
+}
+
+// Returns NULL if the file does not exist or its header does not match its size.
+SnapshotLoad* OpenSnapshot(const std::wstring& path) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return NULL;
+
+    DWORD fileSize = GetFileSize(hFile, NULL);
+    SnapshotHeader header;
+    DWORD recordBytes = 0;
+    if (fileSize >= sizeof(header) && ReadAt(hFile, 0, &header, sizeof(header))) {
+        recordBytes = (DWORD)CheckSnapshotHeader(header, fileSize);
+    }
+    if (!recordBytes) {
+        CloseHandle(hFile);
+        return NULL;
+    }
+
+    SnapshotLoad* load = new SnapshotLoad;
+    load->hFile = hFile;
+    load->header = header;
+    load->fileSize = fileSize;
+    load->read = sizeof(header);
+    load->crc = CRC32_INIT;
+    load->verified = false;
+    load->built = 0;
+    load->recordBytes = recordBytes;
+    titleArena.reserve(fileSize / sizeof(wchar_t));
+    titleArena.resize(sizeof(header) / sizeof(wchar_t));
+    memcpy(&titleArena[0], &header, sizeof(header));
+    return load;
+}
+
+class SnapshotFileReader : public SnapshotReader {
+public:
+    explicit SnapshotFileReader(HANDLE hFile) : hFile(hFile) {}
+    bool ReadAt(size_t offset, void* buffer, size_t bytes) {
+        return ::ReadAt(hFile, (DWORD)offset, buffer, (DWORD)bytes);
+    }
+
+private:
+    HANDLE hFile;
+};
+
+// Reads, verifies and builds for up to `budget` ms. Returns true while there
+// is more to do; otherwise `ok` tells whether load.tasks is the list. The
+// records are checked and turned into tasks without parsing: the file
+// becomes titleArena and each title a view into its heap, 256 records a slice.
+bool StepSnapshotLoad(SnapshotLoad& load, DWORD budget, bool& ok) {
+    DWORD start = GetTickCount();
+    ok = false;
+    while (load.read < load.fileSize) {
+        DWORD chunk = load.fileSize - load.read;
+        if (chunk > LOAD_READ_BYTES) chunk = LOAD_READ_BYTES;
+        size_t at = titleArena.size();
+        titleArena.resize(at + chunk / sizeof(wchar_t));
+        if (!ReadAt(load.hFile, load.read, &titleArena[at], chunk)) return false;
+        load.crc = Crc32Update(load.crc, (const BYTE*)&titleArena[at], chunk);
+        load.read += chunk;
+        if (GetTickCount() - start >= budget) return true;
+    }
+    if (!load.verified) {
+        if ((load.crc ^ CRC32_INIT) != load.header.crc) return false;
+        load.verified = true;
+    }
+
+    const SnapshotHeader& header = load.header;
+    const BYTE* records = (const BYTE*)&titleArena[0] + sizeof(header);
+    size_t heapStart = (sizeof(header) + header.count * load.recordBytes) / sizeof(wchar_t);
+    while (load.built < header.count) {
+        DWORD to = load.built + 256 < header.count ? load.built + 256 : header.count;
+        BuildSnapshotTasks(header, records, load.recordBytes, load.built, to, heapStart, load.tasks);
+        load.built = to;
+        if (load.built < header.count && GetTickCount() - start >= budget) return true;
+    }
+    if (header.nextId > nextTaskId) nextTaskId = header.nextId;
+    ok = true;
+    return false;
+}
+
+// Returns false if the snapshot does not exist.
+bool LoadTextSnapshot(const std::wstring& path) {
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+
     DWORD fileSize = GetFileSize(hFile, NULL);
     if (fileSize <= 2) {
         CloseHandle(hFile);
-        return;
+        return true;
     }
 
-    wchar_t* buffer = new wchar_t[fileSize / 2 + 1];
-    DWORD read;
-    ReadFile(hFile, buffer, fileSize, &read, NULL);
+    titleArena.resize(fileSize / 2 + 1);
+    DWORD read = 0;
+    ReadFile(hFile, &titleArena[0], fileSize, &read, NULL);
     CloseHandle(hFile);
 
-    buffer[read / 2] = L'\0';
-    wchar_t* start = buffer;
-    if (*start == 0xFEFF) start++; // Skip BOM
+    size_t end = read / 2;
+    titleArena.resize(end + 1);
+    titleArena[end] = L'\0';
+    ParseTextSnapshot(0);
+    return true;
+}
+
+void FinishLoadTasks(bool loaded);
+bool ContinueLoadTasks(DWORD budget);
+
+// Loads the active list. With `preview` and a snapshot to load, it returns
+// with the preview in tasks and the rest left to ContinueLoadTasks();
+// otherwise the list is complete on return.
+void BeginLoadTasks(bool preview) {
+    CloseJournal(); // A running fold still reads titleArena
+    listBase = GetListBase(lists[activeList].fileId);
+    std::wstring snapPath = listBase + L".dat";
+    std::wstring tmpPath = listBase + L".tmp";
+
+    // A fold interrupted between delete and rename leaves only the complete tmp file
+    if (FileExists(snapPath)) DeleteFileW(tmpPath.c_str());
+    else MoveFileW(tmpPath.c_str(), snapPath.c_str());
 
     tasks.clear();
-    wchar_t* line = wcstok(start, L"\r\n");
-    while (line) {
-        std::wstring ws(line);
-        size_t sep = ws.find_last_of(L'|');
-        if (sep != std::wstring::npos) {
-            std::wstring title = ws.substr(0, sep);
-            bool completed = (ws.substr(sep + 1, 1) == L"1");
-            tasks.push_back(Task(title));
-            tasks.back().completed = completed;
+    titleArena.clear();
+    ResetSearchIndex();
+    ResetViewIndex();
+    ResetUndo();
+    nextTaskId = 1;
+    snapshotLoad = OpenSnapshot(snapPath);
+    if (snapshotLoad && preview) {
+        SnapshotFileReader reader(snapshotLoad->hFile);
+        LoadSnapshotPreview(snapshotLoad->header, snapshotLoad->recordBytes, reader);
+        SnapScroll(0);
+        return;
+    }
+    while (ContinueLoadTasks(INFINITE)) {
+    }
+}
+
+void LoadTasks() {
+    BeginLoadTasks(false);
+}
+
+// Works on the load for up to `budget` ms; false once the list is complete.
+bool ContinueLoadTasks(DWORD budget) {
+    bool loaded = false;
+    if (snapshotLoad) {
+        if (StepSnapshotLoad(*snapshotLoad, budget, loaded)) return true;
+        CloseHandle(snapshotLoad->hFile);
+        tasks.swap(snapshotLoad->tasks); // Drops the preview
+        if (!loaded) {
+            tasks.clear();
+            titleArena.clear();
+            nextTaskId = 1;
         }
-        line = wcstok(NULL, L"\r\n");
+        delete snapshotLoad;
+        snapshotLoad = NULL;
     }
-    delete[] buffer;
-    targetScrollPos = visualScrollPos = 0.0;
+    FinishLoadTasks(loaded);
+    return false;
+}
+
+void CancelLoadTasks() {
+    if (!snapshotLoad) return;
+    CloseHandle(snapshotLoad->hFile);
+    delete snapshotLoad;
+    snapshotLoad = NULL;
+}
+
+// Falls back if the snapshot did not load, then replays the journal over the
+// list and starts the writer.
+void FinishLoadTasks(bool loaded) {
+    const ListInfo& info = lists[activeList];
+    std::wstring snapPath = listBase + L".dat";
+    std::wstring textPath = listBase + L".txt";
+    std::wstring badPath = listBase + L".bad";
+    bool migrate = false;
+    if (!loaded) {
+        // Keep a damaged snapshot for inspection rather than overwrite it
+        if (FileExists(snapPath)) {
+            DeleteFileW(badPath.c_str());
+            MoveFileW(snapPath.c_str(), badPath.c_str());
+        }
+        migrate = LoadTextSnapshot(textPath);
+        if (!migrate && info.fileId == 0) {
+            // Default tasks, for the first list only
+            tasks.push_back(MakeTask(L"Eat Tofu"));
+            tasks.push_back(MakeTask(L"Stay Mental"));
+            tasks.push_back(MakeTask(L"Build PW-SH2 Apps"));
+        }
+    }
+
+    std::map<unsigned long, size_t> index;
+    for (size_t i = 0; i < tasks.size(); ++i) index[tasks[i].id] = i;
+    bool pendingFold = ReplayJournal(listBase + L".old", index);
+    ReplayJournal(listBase + L".log", index);
+    if (info.nextId > nextTaskId) nextTaskId = info.nextId; // Ids given out while it was unloaded
+
+    // An add of an older id is an undone delete: it goes back to its place in id order
+    std::vector<Task> live;
+    bool inOrder = true;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (tasks[i].id == 0) continue;
+        if (!live.empty() && tasks[i].id < live.back().id) inOrder = false;
+        live.push_back(tasks[i]);
+    }
+    if (!inOrder) std::stable_sort(live.begin(), live.end(), TaskIdLess);
+    tasks.clear();
+    for (size_t i = 0; i < live.size(); ++i) tasks.push_back(live[i]);
+    ResetViewIndex(); // It may have been built over the preview
+
+    OpenJournal(listBase);
+    // A compaction did not finish last run, or tasks.txt is being migrated:
+    // fold everything now, before new records arrive
+    if ((pendingFold || migrate) && FoldSnapshot(listBase, tasks, nextTaskId)) {
+        if (migrate) DeleteFileW(textPath.c_str());
+        if (hJournal != INVALID_HANDLE_VALUE) {
+            SetFilePointer(hJournal, 0, NULL, FILE_BEGIN);
+            SetEndOfFile(hJournal);
+            journalBytes = 0;
+        }
+    }
+    StartJournalWriter();
+    LoadSyncState();
+    SnapScroll(0);
+}
+
+// --- List Catalog ---
+
+int returnList = 0; // Last list that was not cold, for leaving the archive
+
+void AddList(const wchar_t* name, DWORD fileId, bool cold) {
+    ListInfo info;
+    info.name = name;
+    info.fileId = fileId;
+    info.count = 0;
+    info.completed = 0;
+    info.nextId = 1;
+    info.cold = cold;
+    lists.push_back(info);
+}
+
+// Falls back to the default lists if lists.dat is missing or damaged. The
+// lists' own files are left alone, and a summary is refreshed whenever its
+// list is opened.
+void LoadCatalog() {
+    lists.clear();
+    activeList = 0;
+    HANDLE hFile = CreateFileW((GetAppDir() + L"lists.dat").c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE) {
+        DWORD fileSize = GetFileSize(hFile, NULL);
+        std::vector<BYTE> data(fileSize + 1);
+        DWORD read = 0;
+        ReadFile(hFile, &data[0], fileSize, &read, NULL);
+        CloseHandle(hFile);
+
+        CatalogHeader header;
+        bool ok = read == fileSize && read >= sizeof(header);
+        if (ok) {
+            memcpy(&header, &data[0], sizeof(header));
+            ok = header.magic == CATALOG_MAGIC && header.version == CATALOG_VERSION &&
+                 Crc32(&data[sizeof(header)], read - sizeof(header)) == header.crc;
+        }
+        DWORD pos = sizeof(header);
+        for (DWORD i = 0; ok && i < header.count; ++i) {
+            CatalogRecord rec;
+            ok = read - pos >= sizeof(rec);
+            if (!ok) break;
+            memcpy(&rec, &data[pos], sizeof(rec));
+            pos += sizeof(rec);
+            ok = (read - pos) / sizeof(wchar_t) >= rec.nameLen;
+            if (!ok) break;
+            std::wstring name(rec.nameLen, L' ');
+            if (rec.nameLen) memcpy(&name[0], &data[pos], rec.nameLen * sizeof(wchar_t));
+            pos += rec.nameLen * sizeof(wchar_t);
+            AddList(name.c_str(), rec.fileId, (rec.flags & CATALOG_COLD) != 0);
+            lists.back().count = rec.count;
+            lists.back().completed = rec.completed;
+            lists.back().nextId = rec.nextId;
+        }
+        if (ok) activeList = header.activeList;
+        else lists.clear();
+    }
+    if (lists.empty()) {
+        AddList(L"TOFU MENTAL", 0, false);
+        AddList(L"WORK", 1, false);
+        AddList(L"HOME", 2, false);
+        AddList(L"ARCHIVE", 3, true);
+    }
+    if (activeList >= (int)lists.size() || lists[activeList].cold) activeList = 0;
+    returnList = activeList;
+}
+
+void EncodeCatalog(std::vector<BYTE>& data) {
+    data.assign(sizeof(CatalogHeader), 0);
+    for (size_t i = 0; i < lists.size(); ++i) {
+        const ListInfo& info = lists[i];
+        CatalogRecord rec;
+        rec.fileId = info.fileId;
+        rec.count = info.count;
+        rec.completed = info.completed;
+        rec.nextId = info.nextId;
+        rec.nameLen = (WORD)info.name.size();
+        rec.flags = info.cold ? CATALOG_COLD : 0;
+        size_t at = data.size();
+        data.resize(at + sizeof(rec) + rec.nameLen * sizeof(wchar_t));
+        memcpy(&data[at], &rec, sizeof(rec));
+        if (rec.nameLen) memcpy(&data[at + sizeof(rec)], info.name.c_str(), rec.nameLen * sizeof(wchar_t));
+    }
+    CatalogHeader header;
+    header.magic = CATALOG_MAGIC;
+    header.version = CATALOG_VERSION;
+    header.activeList = (WORD)activeList;
+    header.count = (DWORD)lists.size();
+    header.crc = Crc32(&data[sizeof(header)], (DWORD)(data.size() - sizeof(header)));
+    memcpy(&data[0], &header, sizeof(header));
+}
+
+void SaveCatalog() {
+    std::vector<BYTE> data;
+    EncodeCatalog(data);
+    WriteWholeFile(GetAppDir() + L"lists.dat", GetAppDir() + L"lists.tmp", data);
+}
+
+// Hands the writer an archive to run after any compaction already posted.
+// The records queued so far go out ahead of its deletes.
+void PostArchive(ArchiveJob* job) {
+    EnterCriticalSection(&journalLock);
+    job->records.insert(job->records.begin(), journalQueue.begin(), journalQueue.end());
+    job->queued = journalQueue.size();
+    journalQueue.clear();
+    LeaveCriticalSection(&journalLock);
+    InterlockedExchange(&archiveBusy, 1);
+    if (!hWriterThread) {
+        if (RunArchive(job)) archiveBusy = 0;
+        return;
+    }
+    EnterCriticalSection(&journalLock);
+    archiveJob = job;
+    LeaveCriticalSection(&journalLock);
+    SetEvent(hWriterEvent);
+}
+
+// Brings the catalog and the list's sync state up to date with the list.
+void SaveListState() {
+    SummarizeActiveList();
+    SaveSyncState();
+    SaveCatalog();
+}
+
+// Leaves the active list, resident if it fits the cache, and opens list `to`.
+void SwitchList(int to) {
+    if (to == activeList || to < 0 || to >= (int)lists.size()) return;
+    CloseJournal();
+    SummarizeActiveList();
+    SaveSyncState();
+    if (!lists[activeList].cold) returnList = activeList;
+    ParkActiveList();
+    activeList = to;
+    ResetSearchIndex();
+    ResetViewIndex();
+    ResetUndo();
+    if (RestoreList(lists[to].fileId)) {
+        listBase = GetListBase(lists[to].fileId);
+        OpenJournal(listBase);
+        StartJournalWriter();
+        LoadSyncState();
+        SnapScroll(selectedIndex);
+    } else {
+        LoadTasks();
+    }
+    TrimResidentLists(LIST_CACHE_BYTES);
+    SummarizeActiveList();
+    SaveCatalog();
+}
+
+// Moves the active list's completed tasks to the cold list without loading
+// it: they are appended to its journal under ids from its catalog entry. The
+// writer saves the catalog before that write and journals the deletes after
+// it, so a crash can skip ids or leave a task in both lists, but never
+// reuses an id or loses a task.
+bool ArchiveCompleted() {
+    int cold = FindColdList();
+    if (cold < 0 || cold == activeList || archiveBusy) return false;
+    ListInfo& archive = lists[cold];
+
+    ArchiveJob* job = new ArchiveJob;
+    job->base = GetListBase(archive.fileId);
+    std::vector<Task> moved;
+    TaskStore kept;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const Task& t = tasks[i];
+        if (!t.completed) {
+            kept.push_back(t);
+            continue;
+        }
+        Task copy = t;
+        copy.id = archive.nextId++;
+        EncodeJournalRecord(JOP_ADD, copy, job->adds);
+        moved.push_back(t);
+    }
+    if (moved.empty()) {
+        delete job;
+        return false;
+    }
+    archive.count += (DWORD)moved.size();
+    archive.completed += (DWORD)moved.size();
+    tasks.swap(kept);
+    ResetViewIndex();
+    SummarizeActiveList();
+    EncodeCatalog(job->catalog);
+
+    for (size_t i = 0; i < moved.size(); ++i) {
+        UnindexTask(moved[i]);
+        NoteSyncEdit(SYNC_DELETE, moved[i]);
+        EncodeJournalRecord(JOP_DELETE, moved[i], job->records);
+    }
+    journalBytes += (DWORD)job->records.size();
+    PostArchive(job);
+    ResetUndo(); // Logged positions no longer hold
+    if (selectedIndex >= (int)tasks.size()) selectedIndex = (int)tasks.size() - 1;
+    if (selectedIndex < 0) selectedIndex = 0;
+    SnapScroll(selectedIndex);
+    return true;
 }
 
 // --- UI Helpers ---
@@ -158,43 +1268,713 @@ void DrawDotMatrixChar(HDC hdc, int x, int y, TCHAR c, COLORREF color) {
     UNREFERENCED_PARAMETER(color);
 }
 
+// --- GDI Resource Cache ---
+// Pens and brushes are created on first use and kept until WM_DESTROY, so a
+// steady-state frame performs no GDI object creation at all. Fonts are
+// already created once in WM_CREATE.
+
+enum GdiKind { GDI_PEN, GDI_BRUSH };
+
+struct GdiCacheEntry {
+    GdiKind kind;
+    COLORREF color;
+    int width;
+    HGDIOBJ obj;
+};
+
+std::vector<GdiCacheEntry> gdiCache;
+int gdiCreations = 0;          // Total objects created by the cache
+int gdiCreationsLastFrame = 0; // Created during the last WM_PAINT; 0 in steady state
+
+HGDIOBJ GetCachedGdiObject(GdiKind kind, COLORREF color, int width) {
+    for (size_t i = 0; i < gdiCache.size(); ++i) {
+        const GdiCacheEntry& e = gdiCache[i];
+        if (e.kind == kind && e.color == color && e.width == width) return e.obj;
+    }
+    GdiCacheEntry e;
+    e.kind = kind;
+    e.color = color;
+    e.width = width;
+    e.obj = (kind == GDI_PEN) ? (HGDIOBJ)CreatePen(PS_SOLID, width, color) : (HGDIOBJ)CreateSolidBrush(color);
+    gdiCache.push_back(e);
+    ++gdiCreations;
+    return e.obj;
+}
+
+HPEN GetCachedPen(COLORREF color, int width) {
+    return (HPEN)GetCachedGdiObject(GDI_PEN, color, width);
+}
+
+HBRUSH GetCachedBrush(COLORREF color) {
+    return (HBRUSH)GetCachedGdiObject(GDI_BRUSH, color, 0);
+}
+
+void ClearGdiCache() {
+    for (size_t i = 0; i < gdiCache.size(); ++i) DeleteObject(gdiCache[i].obj);
+    gdiCache.clear();
+}
+
 void DrawRoundedRect(HDC hdc, RECT r, int radius, COLORREF borderCol, COLORREF fillCol) {
-    HBRUSH hBrush = CreateSolidBrush(fillCol);
-    HPEN hPen = CreatePen(PS_SOLID, 1, borderCol);
-    HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, hBrush);
-    HPEN hOldPen = (HPEN)SelectObject(hdc, hPen);
+    HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, GetCachedBrush(fillCol));
+    HPEN hOldPen = (HPEN)SelectObject(hdc, GetCachedPen(borderCol, 1));
 
     RoundRect(hdc, r.left, r.top, r.right, r.bottom, radius * 2, radius * 2);
 
     SelectObject(hdc, hOldBrush);
     SelectObject(hdc, hOldPen);
-    DeleteObject(hBrush);
-    DeleteObject(hPen);
 }
 
-void InitApp() {
-    LoadTasks();
+// --- RGB565 Canvas ---
+// The back buffer and sprite atlas are 16bpp DIB sections, so fills, the
+// focus frame, indicators and seams are drawn by Canvas565 kernels straight
+// into their memory. GDI only draws text. If a DIB section cannot be created
+// the same shapes fall back to GDI calls on a compatible bitmap.
+
+Pixel565 ToPixel565(COLORREF c) {
+    return RGB565(GetRValue(c), GetGValue(c), GetBValue(c));
 }
 
-// --- Animation Helper ---
+// GDI batches calls on the desktop; finish them before touching DIB memory.
+void SyncCanvas() {
+#ifndef UNDER_CE
+    GdiFlush();
+#endif
+}
 
-void StartScrollAnimation(int newIdx, HWND hWnd) {
-    if (tasks.empty()) return;
-    
-    double startPos = visualScrollPos;
-    double targetPos = (double)newIdx;
+struct BITMAPINFO565 {
+    BITMAPINFOHEADER bmiHeader;
+    DWORD bmiMasks[3];
+};
+
+// Top-down RGB565 DIB section attached to canvas; NULL if it cannot be created.
+HBITMAP CreateCanvasBitmap(HDC hdc, int width, int height, Canvas565& canvas) {
+    BITMAPINFO565 bmi;
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 16;
+    bmi.bmiHeader.biCompression = BI_BITFIELDS;
+    bmi.bmiMasks[0] = 0xF800;
+    bmi.bmiMasks[1] = 0x07E0;
+    bmi.bmiMasks[2] = 0x001F;
+
+    void* bits = NULL;
+    HBITMAP hbm = CreateDIBSection(hdc, (BITMAPINFO*)&bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (hbm && bits) canvas.Attach((Pixel565*)bits, width, height, (width + 1) & ~1);
+    else canvas.Detach();
+    return hbm;
+}
+
+void FillBackground(HDC hdc, Canvas565& canvas, const RECT& r) {
+    if (canvas.IsValid()) canvas.FillRect(r.left, r.top, r.right, r.bottom, ToPixel565(CLR_BG));
+    else FillRect(hdc, &r, GetCachedBrush(CLR_BG));
+}
+
+void DrawFocusFrame(HDC hdc, Canvas565& canvas, const RECT& r, COLORREF fillCol) {
+    if (canvas.IsValid()) {
+        canvas.FillRoundRect(r.left, r.top, r.right, r.bottom, CORNER_RADIUS, ToPixel565(fillCol), ToPixel565(CLR_GLASS_BORDER));
+    } else {
+        DrawRoundedRect(hdc, r, CORNER_RADIUS, CLR_GLASS_BORDER, fillCol);
+    }
+}
+
+void DrawSeam(HDC hdc, Canvas565& canvas, int left, int right, int seamY) {
+    if (canvas.IsValid()) {
+        canvas.DottedSeam(left, right, seamY, 8, ToPixel565(RGB(60, 60, 60)), ToPixel565(CLR_TEXT_SEC));
+        return;
+    }
+    HPEN hOldP = (HPEN)SelectObject(hdc, GetCachedPen(RGB(60, 60, 60), 1));
+    MoveToEx(hdc, left, seamY, NULL); LineTo(hdc, right, seamY);
+    for (int dx = left; dx < right; dx += 8) {
+        SetPixel(hdc, dx, seamY - 2, CLR_TEXT_SEC); SetPixel(hdc, dx, seamY + 2, CLR_TEXT_SEC);
+    }
+    SelectObject(hdc, hOldP);
+}
+
+void DrawIndicator(HDC hdc, Canvas565& canvas, const RECT& itemRect, bool completed) {
+    RECT checkRect = { itemRect.left + GRID_UNIT, itemRect.top + GRID_UNIT, 
+                       itemRect.left + GRID_UNIT * 3, itemRect.top + ITEM_HEIGHT - GRID_UNIT };
+    int left = checkRect.left + 4;
+    int top = checkRect.top + 12;
+    int right = checkRect.right - 4;
+
+    if (canvas.IsValid()) {
+        if (completed) {
+            canvas.FillCircle(left, top, right, ToPixel565(CLR_TEXT_PRI));
+            canvas.StrokeCircle(left, top, right, ToPixel565(RGB(0, 0, 0)));
+        } else {
+            canvas.StrokeCircle(left, top, right, ToPixel565(CLR_TEXT_SEC));
+        }
+    } else if (completed) {
+        HBRUSH hOldB = (HBRUSH)SelectObject(hdc, GetCachedBrush(CLR_TEXT_PRI));
+        Ellipse(hdc, left, top, right, checkRect.bottom - 12);
+        SelectObject(hdc, hOldB);
+    } else {
+        HPEN hOldP = (HPEN)SelectObject(hdc, GetCachedPen(CLR_TEXT_SEC, 1));
+        SelectObject(hdc, GetStockObject(NULL_BRUSH));
+        Ellipse(hdc, left, top, right, checkRect.bottom - 12);
+        SelectObject(hdc, hOldP);
+    }
+}
+
+// --- Title Layout ---
+// Titles too long for their row end in an ellipsis. Where to cut is measured
+// the first time a row is drawn and kept per (task, title revision, font,
+// width) in a small direct-mapped table, so an edit, a resize or a new font
+// each just miss it. The title being typed is measured one glyph at a time
+// instead, and scrolls sideways to keep the caret in view.
+
+#define TITLE_LAYOUT_SLOTS 256 // Power of two, well over a screen of rows
+#define TITLE_ELLIPSIS L"\x2026"
+
+struct TitleLayout {
+    DWORD taskId; // 0 marks a free slot
+    DWORD revision;
+    DWORD fontGeneration;
+    int available; // Pixels the title may use
+    int fit;       // Characters before the ellipsis; the whole length if it fits
+};
 
-    // Shortest path logic for infinite loop
-    double diff = targetPos - startPos;
-    int n = (int)tasks.size();
-    if (diff > n / 2.0) targetPos -= n;
-    else if (diff < -n / 2.0) targetPos += n;
+struct EditLayout {
+    DWORD taskId; // 0 until the first draw
+    DWORD fontGeneration;
+    std::wstring text;     // The title as last measured
+    std::vector<int> ends; // ends[k]: width of text's first k + 1 characters
+    int caretWidth;
+    int height;
+};
+
+TitleLayout titleLayouts[TITLE_LAYOUT_SLOTS];
+EditLayout editLayout;
+DWORD titleFontGeneration = 1; // Bumped whenever hFontMain is created
+
+void DropAllTitleLayouts() {
+    memset(titleLayouts, 0, sizeof(titleLayouts));
+    editLayout.taskId = 0;
+}
+
+// hFontMain must be selected into hdc.
+const TitleLayout& GetTitleLayout(HDC hdc, const Task& t, int available) {
+    TitleLayout& l = titleLayouts[t.id & (TITLE_LAYOUT_SLOTS - 1)];
+    if (l.taskId == t.id && l.revision == t.title.Revision() && l.fontGeneration == titleFontGeneration &&
+        l.available == available) {
+        return l;
+    }
+    int len = (int)t.title.size();
+    int fit = len;
+    SIZE size;
+    GetTextExtentExPoint(hdc, t.title.c_str(), len, available, &fit, NULL, &size);
+    if (fit < len) {
+        SIZE ellipsis;
+        GetTextExtentPoint32(hdc, TITLE_ELLIPSIS, 1, &ellipsis);
+        int room = available - ellipsis.cx;
+        if (room < 0) room = 0;
+        GetTextExtentExPoint(hdc, t.title.c_str(), fit, room, &fit, NULL, &size);
+    }
+    l.taskId = t.id;
+    l.revision = t.title.Revision();
+    l.fontGeneration = titleFontGeneration;
+    l.available = available;
+    l.fit = fit;
+    return l;
+}
+
+// The row of the task being added: the title from its start, or its tail
+// when it no longer fits, with the caret after it.
+void DrawEditRowText(HDC hdc, const RECT& textRect, const Task& t, COLORREF textCol, bool caret) {
+    SelectObject(hdc, hFontMain);
+    SetTextColor(hdc, textCol);
+    EditLayout& l = editLayout;
+    if (l.taskId != t.id || l.fontGeneration != titleFontGeneration) {
+        SIZE size;
+        GetTextExtentPoint32(hdc, L"_", 1, &size);
+        l.taskId = t.id;
+        l.fontGeneration = titleFontGeneration;
+        l.text.clear();
+        l.ends.clear();
+        l.caretWidth = size.cx;
+        l.height = size.cy;
+    }
+
+    // Typing appends or removes at the end: keep the prefix still shared
+    // and measure only what follows it
+    const wchar_t* s = t.title.c_str();
+    size_t len = t.title.size();
+    size_t keep = 0;
+    while (keep < l.text.size() && keep < len && l.text[keep] == s[keep]) ++keep;
+    l.text.erase(keep);
+    l.ends.resize(keep);
+    for (size_t k = keep; k < len; ++k) {
+        SIZE size;
+        GetTextExtentPoint32(hdc, s + k, 1, &size);
+        l.ends.push_back((k ? l.ends[k - 1] : 0) + size.cx);
+        l.text += s[k];
+    }
+
+    int caretX = l.ends.empty() ? 0 : l.ends.back();
+    int scrollX = caretX + l.caretWidth - (textRect.right - textRect.left);
+    if (scrollX < 0) scrollX = 0;
+    int x = textRect.left - scrollX;
+    int y = textRect.top + (textRect.bottom - textRect.top - l.height) / 2;
+    ExtTextOut(hdc, x, y, ETO_CLIPPED, &textRect, s, (UINT)len, NULL);
+    if (caret) ExtTextOut(hdc, x + caretX, y, ETO_CLIPPED, &textRect, L"_", 1, NULL);
+}
+
+// --- Row Sprite Cache ---
+// Each title is rendered once per (task, title revision, completion) at full
+// brightness into a slot of one RGB565 atlas, then laid onto the back buffer
+// by Canvas565::OrBlitFaded, which applies the distance fade. A scroll frame
+// therefore does no text rasterization, and one sprite serves a row at every
+// distance. The atlas is sized from SPRITE_CACHE_BUDGET and slots are
+// recycled least recently used.
+
+#define SPRITE_CACHE_BUDGET (1536 * 1024) // bytes
+
+struct RowSprite {
+    DWORD taskId; // 0 marks a free slot
+    DWORD revision;
+    bool completed;
+    BYTE priority;
+    WORD due;
+    DWORD lastUse;
+    RowSprite() : taskId(0), revision(0), completed(false), priority(0), due(0), lastUse(0) {}
+};
 
-    targetScrollPos = targetPos;
-    startScrollPos = startPos;
-    animStartTime = GetTickCount();
-    isAnimating = true;
-    SetTimer(hWnd, 1, 16, NULL); // ~60fps
+HDC hdcSprites = NULL;
+HBITMAP hbmSprites = NULL;
+HBITMAP hbmSpritesOld = NULL;
+Canvas565 spriteCanvas;
+std::vector<RowSprite> rowSprites;
+int spriteWidth = 0;
+DWORD spriteClock = 0;
+
+// Core row alpha (0..255) as a Canvas565 fade factor
+int AlphaToFade(int alpha) {
+    return (alpha * FADE_ONE + 127) / 255;
+}
+
+COLORREF GetRowTextColor(const Task& t, int alpha) {
+    COLORREF baseCol = t.completed ? CLR_TEXT_SEC : CLR_TEXT_PRI;
+    return RGB(GetRValue(baseCol) * alpha / 255, GetGValue(baseCol) * alpha / 255, GetBValue(baseCol) * alpha / 255);
+}
+
+// "!!!" down to "!" for priorities 1 to 3, then the due day as M/D.
+std::wstring FormatPlanTag(const Task& t) {
+    std::wstring tag;
+    if (t.priority) tag.append(PRIORITY_LEVELS + 1 - t.priority, L'!');
+    if (t.due) {
+        int year, month, day;
+        DayToDate(t.due, year, month, day);
+        TCHAR text[16];
+        wsprintf(text, TEXT("%s%d/%d"), tag.empty() ? TEXT("") : TEXT(" "), month, day);
+        tag += text;
+    }
+    return tag;
+}
+
+void DrawRowText(HDC hdc, const RECT& textRect, const Task& t, COLORREF textCol) {
+    SelectObject(hdc, hFontMain);
+    SetTextColor(hdc, textCol);
+    RECT r = textRect;
+    std::wstring tag = FormatPlanTag(t);
+    if (!tag.empty()) {
+        // Right-aligned inside the frame; the title stops short of it
+        SIZE size;
+        GetTextExtentPoint32(hdc, tag.c_str(), (int)tag.size(), &size);
+        RECT tagRect = r;
+        tagRect.right -= MARGIN_X;
+        DrawText(hdc, tag.c_str(), (int)tag.size(), &tagRect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE);
+        r.right = tagRect.right - size.cx - MARGIN_X;
+    }
+    const TitleLayout& layout = GetTitleLayout(hdc, t, r.right - r.left);
+    if (layout.fit < (int)t.title.size()) {
+        std::wstring shown(t.title.c_str(), layout.fit);
+        shown += TITLE_ELLIPSIS;
+        DrawText(hdc, shown.c_str(), (int)shown.size(), &r, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
+    } else {
+        DrawText(hdc, t.title.c_str(), (int)t.title.size(), &r, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
+    }
+}
+
+void DestroySpriteCache() {
+    if (hdcSprites) {
+        SelectObject(hdcSprites, hbmSpritesOld);
+        DeleteObject(hbmSprites);
+        DeleteDC(hdcSprites);
+        hdcSprites = NULL;
+        hbmSprites = NULL;
+    }
+    spriteCanvas.Detach();
+    rowSprites.clear();
+}
+
+void CreateSpriteCache(HDC hdcRef, int width) {
+    DestroySpriteCache();
+    if (width <= 0) return;
+    int slots = SPRITE_CACHE_BUDGET / (((width + 1) & ~1) * ITEM_HEIGHT * (int)sizeof(Pixel565));
+    if (slots < 1) return; // Rows are drawn directly
+
+    hdcSprites = CreateCompatibleDC(hdcRef);
+    hbmSprites = CreateCanvasBitmap(hdcRef, width, slots * ITEM_HEIGHT, spriteCanvas);
+    if (!hbmSprites || !spriteCanvas.IsValid()) {
+        if (hbmSprites) DeleteObject(hbmSprites);
+        DeleteDC(hdcSprites);
+        hdcSprites = NULL;
+        hbmSprites = NULL;
+        return;
+    }
+    hbmSpritesOld = (HBITMAP)SelectObject(hdcSprites, hbmSprites);
+    SetBkMode(hdcSprites, TRANSPARENT);
+    rowSprites.assign(slots, RowSprite());
+    spriteWidth = width;
+}
+
+// Returns the atlas slot holding t's title, rendering it on a miss, or -1 if
+// there is no atlas.
+int GetRowSprite(const Task& t) {
+    if (!hdcSprites) return -1;
+    int victim = 0;
+    for (int s = 0; s < (int)rowSprites.size(); ++s) {
+        RowSprite& sp = rowSprites[s];
+        if (sp.taskId == t.id && sp.revision == t.title.Revision() && sp.completed == t.completed &&
+            sp.priority == t.priority && sp.due == t.due) {
+            sp.lastUse = ++spriteClock;
+            return s;
+        }
+        if (sp.lastUse < rowSprites[victim].lastUse) victim = s;
+    }
+
+    RECT slotRect = { 0, victim * ITEM_HEIGHT, spriteWidth, (victim + 1) * ITEM_HEIGHT };
+    spriteCanvas.FillRect(slotRect.left, slotRect.top, slotRect.right, slotRect.bottom, ToPixel565(CLR_BG));
+    DrawRowText(hdcSprites, slotRect, t, GetRowTextColor(t, 255));
+    SyncCanvas();
+
+    RowSprite& sp = rowSprites[victim];
+    sp.taskId = t.id;
+    sp.revision = t.title.Revision();
+    sp.completed = t.completed;
+    sp.priority = t.priority;
+    sp.due = t.due;
+    sp.lastUse = ++spriteClock;
+    return victim;
+}
+
+// Frees the slots of a task whose sprites can no longer be hit.
+void DropRowSprites(DWORD taskId) {
+    for (size_t s = 0; s < rowSprites.size(); ++s) {
+        if (rowSprites[s].taskId == taskId) rowSprites[s] = RowSprite();
+    }
+}
+
+// Task ids are only unique within a list, so switching lists frees every
+// slot, and every title layout with them.
+void DropAllRowSprites() {
+    rowSprites.assign(rowSprites.size(), RowSprite());
+    DropAllTitleLayouts();
+}
+
+// --- Back Buffer & Dirty Regions ---
+// The back buffer lives as long as the window and is rebuilt only on WM_SIZE.
+// Handlers invalidate just the rows, header or footer they changed, and
+// WM_PAINT redraws and blits only ps.rcPaint.
+
+HDC hdcBack = NULL;
+HBITMAP hbmBack = NULL;
+HBITMAP hbmBackOld = NULL;
+Canvas565 backCanvas;
+FrameStats lastFrameStats; // Layout cost of the last WM_PAINT
+
+void DestroyBackBuffer() {
+    if (hdcBack) {
+        SelectObject(hdcBack, hbmBackOld);
+        DeleteObject(hbmBack);
+        DeleteDC(hdcBack);
+        hdcBack = NULL;
+        hbmBack = NULL;
+    }
+    backCanvas.Detach();
+    DestroySpriteCache();
+}
+
+void CreateBackBuffer(HWND hWnd) {
+    DestroyBackBuffer();
+    if (clientRect.right <= 0 || clientRect.bottom <= 0) return;
+    HDC hdc = GetDC(hWnd);
+    hdcBack = CreateCompatibleDC(hdc);
+    hbmBack = CreateCanvasBitmap(hdc, clientRect.right, clientRect.bottom, backCanvas);
+    if (!hbmBack) hbmBack = CreateCompatibleBitmap(hdc, clientRect.right, clientRect.bottom);
+    hbmBackOld = (HBITMAP)SelectObject(hdcBack, hbmBack);
+    // Sprites hold only the title, which starts TEXT_INDENT into the row
+    if (backCanvas.IsValid()) CreateSpriteCache(hdc, clientRect.right - MARGIN_X * 2 - TEXT_INDENT);
+    ReleaseDC(hWnd, hdc);
+}
+
+RECT ToRECT(const LayoutRect& l) {
+    RECT r = { l.left, l.top, l.right, l.bottom };
+    return r;
+}
+
+void InvalidateLayoutRect(HWND hWnd, const LayoutRect& l) {
+    RECT r = ToRECT(l);
+    InvalidateRect(hWnd, &r, FALSE);
+}
+
+void InvalidateRow(HWND hWnd, int slot) {
+    InvalidateLayoutRect(hWnd, GetRowRect(clientRect.right, clientRect.bottom, slot));
+}
+
+void InvalidateHeader(HWND hWnd) {
+    InvalidateLayoutRect(hWnd, GetHeaderRect(clientRect.right, clientRect.bottom));
+}
+
+void InvalidateFooter(HWND hWnd) {
+    InvalidateLayoutRect(hWnd, GetFooterRect(clientRect.right, clientRect.bottom));
+}
+
+// Just the caret cell of the row being typed in, from where the last frame
+// measured it.
+void InvalidateCaret(HWND hWnd) {
+    LayoutRect row = GetRowRect(clientRect.right, clientRect.bottom, 0);
+    int textLeft = row.left + MARGIN_X + TEXT_INDENT; // As EmitFrame lays out the text
+    if (editLayout.taskId == 0) {
+        InvalidateLayoutRect(hWnd, row);
+        return;
+    }
+    int caretX = editLayout.ends.empty() ? 0 : editLayout.ends.back();
+    int available = row.right - MARGIN_X - textLeft;
+    if (caretX + editLayout.caretWidth > available) caretX = available - editLayout.caretWidth; // Scrolled
+    InvalidateLayoutRect(hWnd, MakeLayoutRect(textLeft + caretX, row.top, textLeft + caretX + editLayout.caretWidth, row.bottom));
+}
+
+// A toggle moves the task to another row when the view is ordered.
+void InvalidateToggledRow(HWND hWnd) {
+    if (viewOrder == ORDER_LIST) InvalidateRow(hWnd, 0);
+    else InvalidateRect(hWnd, NULL, FALSE);
+}
+
+// --- Task Plans ---
+// Priority and due day are set from the keyboard: 1-3 set a priority (again
+// to clear it) and T steps the due day through today, tomorrow, a week out
+// and none.
+
+unsigned short Today() {
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    return DayNumber(st.wYear, st.wMonth, st.wDay);
+}
+
+unsigned short NextDueDay(unsigned short due) {
+    unsigned short today = Today();
+    if (due == 0) return today;
+    if (due == today) return (unsigned short)(today + 1);
+    if (due == today + 1) return (unsigned short)(today + 7);
+    return 0;
+}
+
+// Journals a plan change and follows the task to its row in the view.
+void CommitPlanChange(int at, HWND hWnd) {
+    DropRowSprites(tasks[at].id);
+    AppendJournal(JOP_SET_PLAN, tasks[at]);
+    int row = TaskToView(at);
+    if (row != selectedIndex) {
+        selectedIndex = row;
+        StartScrollAnimation(selectedIndex, hWnd);
+    }
+    InvalidateRect(hWnd, NULL, FALSE);
+}
+
+// --- Performance HUD ---
+// Shown in the header, right-aligned, while perfHudVisible; refreshed every
+// PERF_HUD_MS by its own timer rather than by the frames it measures.
+
+// Fills text with fps over the last second, p50/p99 paint time over the last
+// PERF_HUD_FRAMES frames, the last journal write, and timer wakeups over the
+// last second (the HUD's own refresh is not counted; idle should read 0).
+void FormatPerfHud(TCHAR* text) {
+    LONG count = perfCount;
+    LONG first = count > PERF_RING_SIZE ? count - PERF_RING_SIZE : 0;
+    DWORD now = PerfNow();
+    int fps = 0;
+    int wakes = 0;
+    DWORD frames[PERF_HUD_FRAMES];
+    int nFrames = 0;
+    DWORD lastSave = 0;
+    bool haveSave = false;
+    for (LONG n = count - 1; n >= first; --n) {
+        const PerfEvent& e = perfRing[n & (PERF_RING_SIZE - 1)];
+        if (e.kind == PERF_FRAME_END) {
+            if (now - e.time < 1000000) ++fps;
+            if (nFrames < PERF_HUD_FRAMES) frames[nFrames++] = e.value;
+        } else if (e.kind == PERF_WAKE) {
+            if (now - e.time < 1000000) ++wakes;
+        } else if (e.kind == PERF_SAVE && !haveSave) {
+            lastSave = e.value;
+            haveSave = true;
+        }
+    }
+    std::sort(frames, frames + nFrames);
+    DWORD p50 = nFrames ? frames[(nFrames - 1) / 2] : 0;
+    DWORD p99 = nFrames ? frames[(nFrames - 1) * 99 / 100] : 0;
+    // wsprintf has no %f: tenths of a millisecond by hand
+    wsprintf(text, TEXT("FPS %d P50 %d.%d P99 %d.%d SV %d.%d WK %d"), fps,
+             (int)(p50 / 1000), (int)(p50 / 100 % 10), (int)(p99 / 1000), (int)(p99 / 100 % 10),
+             (int)(lastSave / 1000), (int)(lastSave / 100 % 10), wakes);
+}
+
+// Writes the ring, oldest first, to perf.csv next to the executable.
+void DumpPerfTrace() {
+    static const char* names[PERF_KIND_COUNT] = { "frame_start", "frame_end", "timer", "save", "fold", "gdi", "wake" };
+    LONG count = perfCount;
+    LONG first = count > PERF_RING_SIZE ? count - PERF_RING_SIZE : 0;
+    std::string csv = "time_us,event,value\r\n";
+    for (LONG n = first; n < count; ++n) {
+        const PerfEvent& e = perfRing[n & (PERF_RING_SIZE - 1)];
+        char line[64];
+        sprintf(line, "%lu,%s,%lu\r\n", (unsigned long)e.time, e.kind < PERF_KIND_COUNT ? names[e.kind] : "?", (unsigned long)e.value);
+        csv += line;
+    }
+    HANDLE hFile = CreateFileW((GetAppDir() + L"perf.csv").c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return;
+    DWORD written = 0;
+    WriteFile(hFile, csv.data(), (DWORD)csv.size(), &written, NULL);
+    CloseHandle(hFile);
+}
+
+// --- Win32 Frame Sink ---
+// Carries out the core's frame commands on the back buffer: shapes through
+// the canvas (or GDI without a DIB), titles through the sprite atlas.
+
+class GdiFrameSink : public FrameSink {
+public:
+    GdiFrameSink(HDC hdc, Canvas565& canvas) : hdc(hdc), canvas(canvas) {}
+
+    void Background(const LayoutRect& r) {
+        FillBackground(hdc, canvas, ToRECT(r));
+        SetBkMode(hdc, TRANSPARENT);
+    }
+
+    void FocusFrame(const LayoutRect& r, bool editing) {
+        DrawFocusFrame(hdc, canvas, ToRECT(r), editing ? RGB(60,20,20) : RGB(30,30,30));
+    }
+
+    void Seam(int left, int right, int y) {
+        DrawSeam(hdc, canvas, left, right, y);
+    }
+
+    void Indicator(const LayoutRect& itemRect, bool completed) {
+        DrawIndicator(hdc, canvas, ToRECT(itemRect), completed);
+    }
+
+    void RowTitle(const LayoutRect& textRect, const Task& t, int alpha, bool editing, bool caret) {
+        int sprite = editing ? -1 : GetRowSprite(t);
+        if (sprite >= 0) {
+            canvas.OrBlitFaded(spriteCanvas, 0, sprite * ITEM_HEIGHT, textRect.left, textRect.top, spriteWidth, ITEM_HEIGHT, AlphaToFade(alpha));
+        } else {
+            if (editing) DrawEditRowText(hdc, ToRECT(textRect), t, GetRowTextColor(t, alpha), caret);
+            else DrawRowText(hdc, ToRECT(textRect), t, GetRowTextColor(t, alpha));
+            SyncCanvas();
+        }
+    }
+
+    void Header(const LayoutRect& r, AppMode mode, const wchar_t* query, const wchar_t* listName) {
+        RECT headerRect = ToRECT(r);
+        SelectObject(hdc, hFontDot);
+        SetTextColor(hdc, CLR_TEXT_PRI);
+        SetBkMode(hdc, TRANSPARENT);
+        if (mode == MODE_SEARCH) {
+            std::wstring headerText = L"::: FIND: ";
+            headerText += query;
+            headerText += L"_";
+            DrawText(hdc, headerText.c_str(), -1, &headerRect, DT_LEFT | DT_BOTTOM);
+        } else if (mode == MODE_ADD) {
+            DrawText(hdc, TEXT("::: NEW TASK :::"), -1, &headerRect, DT_LEFT | DT_BOTTOM);
+        } else {
+            std::wstring headerText = L"::: ";
+            headerText += listName;
+            if (viewOrder != ORDER_LIST) {
+                headerText += L" / ";
+                headerText += ViewOrderName();
+            }
+            headerText += L" :::";
+            DrawText(hdc, headerText.c_str(), -1, &headerRect, DT_LEFT | DT_BOTTOM);
+        }
+        if (perfHudVisible) {
+            TCHAR hud[64];
+            FormatPerfHud(hud);
+            DrawText(hdc, hud, -1, &headerRect, DT_RIGHT | DT_BOTTOM | DT_SINGLELINE);
+        }
+    }
+
+    void Footer(const LayoutRect& r, AppMode mode, size_t count) {
+        RECT footerRect = ToRECT(r);
+        SelectObject(hdc, hFontDot);
+        SetTextColor(hdc, CLR_TEXT_SEC);
+        TCHAR footerText[64];
+        if (IsLoadingTasks()) { // The preview's count is not the list's
+            lstrcpy(footerText, TEXT("LOADING | ITEMS: --"));
+        } else {
+            wsprintf(footerText, TEXT("%s | ITEMS: %02d"), 
+                (mode == MODE_ADD) ? TEXT("INPUT") : (mode == MODE_SEARCH) ? TEXT("FIND") : TEXT("DEFAULT"), (int)count);
+        }
+        DrawText(hdc, footerText, -1, &footerRect, DT_RIGHT | DT_SINGLELINE);
+    }
+
+private:
+    HDC hdc;
+    Canvas565& canvas;
+};
+
+// --- Startup Profile ---
+// Tick counts at each phase of a cold start, written to startup.log once the
+// list has finished loading.
+
+enum StartupPhase { PHASE_PROCESS, PHASE_WINDOW, PHASE_FONTS, PHASE_PREVIEW, PHASE_FIRST_PAINT, PHASE_LOADED, PHASE_COUNT };
+
+DWORD startupTicks[PHASE_COUNT];
+bool startupMarked[PHASE_COUNT];
+
+void MarkStartup(StartupPhase phase) {
+    if (startupMarked[phase]) return;
+    startupTicks[phase] = GetTickCount();
+    startupMarked[phase] = true;
+}
+
+void WriteStartupLog() {
+    static const char* names[PHASE_COUNT] = { "process", "window", "fonts", "preview", "paint", "loaded" };
+    char text[512];
+    int len = 0;
+    DWORD prev = startupTicks[PHASE_PROCESS];
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        if (!startupMarked[p]) continue;
+        len += sprintf(text + len, "%-8s %6lu ms  +%lu\r\n", names[p],
+                       (unsigned long)(startupTicks[p] - startupTicks[PHASE_PROCESS]), (unsigned long)(startupTicks[p] - prev));
+        prev = startupTicks[p];
+    }
+    len += sprintf(text + len, "tasks    %lu\r\n", (unsigned long)tasks.size());
+
+    HANDLE hFile = CreateFileW((GetAppDir() + L"startup.log").c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return;
+    DWORD written = 0;
+    WriteFile(hFile, text, (DWORD)len, &written, NULL);
+    CloseHandle(hFile);
+}
+
+// Called after the first paint and again when loading ends; the log is
+// written once both have happened.
+void FinishStartupProfile() {
+    if (!startupMarked[PHASE_FIRST_PAINT] || IsLoadingTasks() || startupMarked[PHASE_LOADED]) return;
+    MarkStartup(PHASE_LOADED);
+    WriteStartupLog();
+}
+
+void InitApp() {
+    InitPerf();
+    InitJournalWriter();
+    LoadCatalog();
+    BeginLoadTasks(true);
+    MarkStartup(PHASE_PREVIEW);
 }
 
 // --- Window Procedure ---
@@ -202,7 +1982,7 @@ void StartScrollAnimation(int newIdx, HWND hWnd) {
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     switch (uMsg) {
         case WM_CREATE: {
-            InitApp();
+            MarkStartup(PHASE_WINDOW);
             GetClientRect(hWnd, &clientRect);
             LOGFONT lfMain;
             memset(&lfMain, 0, sizeof(lfMain));
@@ -211,6 +1991,7 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             lfMain.lfQuality = ANTIALIASED_QUALITY;
             lstrcpy(lfMain.lfFaceName, TEXT("MS PGothic"));
             hFontMain = CreateFontIndirect(&lfMain);
+            ++titleFontGeneration;
 
             LOGFONT lfDot;
             memset(&lfDot, 0, sizeof(lfDot));
@@ -220,143 +2001,243 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             lfDot.lfPitchAndFamily = FIXED_PITCH | FF_DONTCARE;
             lstrcpy(lfDot.lfFaceName, TEXT("Courier New"));
             hFontDot = CreateFontIndirect(&lfDot);
+            MarkStartup(PHASE_FONTS);
+
+            InitApp();
+            if (IsLoadingTasks()) SetTimer(hWnd, LOAD_TIMER, 1, NULL); // Timers run once the queue is idle
             break;
         }
 
         case WM_TIMER: {
-            if (isAnimating) {
-                DWORD elapsed = GetTickCount() - animStartTime;
-                double t = (double)elapsed / ANIM_DURATION;
-                if (t >= 1.0) {
-                    t = 1.0;
-                    isAnimating = false;
-                    KillTimer(hWnd, 1);
-                    visualScrollPos = targetScrollPos;
-                    // Normalize only at the very end
-                    double n = (double)tasks.size();
-                    while (visualScrollPos < 0) visualScrollPos += n;
-                    while (visualScrollPos >= n) visualScrollPos -= n;
-                    targetScrollPos = visualScrollPos;
-                    // Ensure selectedIndex matches
-                    selectedIndex = (int)round(visualScrollPos);
-                    while (selectedIndex < 0) selectedIndex += (int)tasks.size();
-                    while (selectedIndex >= (int)tasks.size()) selectedIndex -= (int)tasks.size();
-                } else {
-                    double easedT = 1.0 - pow(1.0 - t, 3);
-                    visualScrollPos = startScrollPos + (targetScrollPos - startScrollPos) * easedT;
+            if (wParam == LOAD_TIMER) {
+                PerfRecord(PERF_WAKE, 0);
+                if (!ContinueLoadTasks(LOAD_SLICE_MS)) {
+                    KillTimer(hWnd, LOAD_TIMER);
+                    FinishStartupProfile();
+                    DropAllRowSprites();
+                    InvalidateRect(hWnd, NULL, FALSE);
                 }
-                InvalidateRect(hWnd, NULL, FALSE);
+                break;
+            }
+            if (wParam == PERF_HUD_TIMER) {
+                InvalidateHeader(hWnd);
+                break;
             }
+            if (wParam == FRAME_TIMER) OnFrameTimer(hWnd);
             break;
         }
 
         case WM_SIZE:
             GetClientRect(hWnd, &clientRect);
+            CreateBackBuffer(hWnd);
             InvalidateRect(hWnd, NULL, TRUE);
             break;
 
-        case WM_LBUTTONDOWN: {
-            if (tasks.empty()) break;
-            int x = (int)(short)LOWORD(lParam);
-            int y = (int)(short)HIWORD(lParam);
-            
+        case WM_LBUTTONDOWN:
+            // Typing goes to the new title or the query; the keys end those modes
+            if (currentMode != MODE_LIST || ViewSize() == 0 || IsLoadingTasks()) break;
+            pressX = (int)(short)LOWORD(lParam);
+            pressY = (int)(short)HIWORD(lParam);
+            BeginDrag(pressY, GetTickCount()); // Stops the wheel where it is
+            ScheduleFrames(hWnd);
+            SetCapture(hWnd);
+            return 0;
+
+        case WM_MOUSEMOVE:
+            if (IsDragging() && DragTo((int)(short)HIWORD(lParam), GetTickCount())) {
+                InvalidateRect(hWnd, NULL, FALSE);
+            }
+            return 0;
+
+        case WM_LBUTTONUP: {
+            if (!IsDragging()) break;
+            ReleaseCapture();
+            if (EndDrag((int)(short)HIWORD(lParam), GetTickCount())) {
+                RequestFrames(hWnd); // Coast
+                InvalidateRect(hWnd, NULL, FALSE);
+                return 0;
+            }
+            RequestFrames(hWnd); // Settles a wheel the press caught between rows
+            if (ViewSize() == 0) return 0; // Emptied by a sync or load since the press
+            int x = pressX;
+            int y = pressY;
+
             RECT rect;
             GetClientRect(hWnd, &rect);
-            int centerY = rect.bottom / 2;
-            int spacing = ITEM_HEIGHT + 2;
-
-            int dy = y - centerY;
-            int slotOffset = (dy >= 0) ? (dy + spacing / 2) / spacing : (dy - spacing / 2) / spacing;
+            int slotOffset = TapSlot(y, rect.bottom);
             
             // Logic: target exactly what was tapped visually (including lap)
-            double newVisualTarget = visualScrollPos + slotOffset;
-            int newIdx = ((int)round(newVisualTarget) % (int)tasks.size() + (int)tasks.size()) % (int)tasks.size();
+            int newVisualRow = SlotToRow(slotOffset);
+            int newIdx = WrapIndex(newVisualRow, (int)ViewSize());
             
-            if (slotOffset == 0 && x >= MARGIN_X && x < MARGIN_X + GRID_UNIT * 5) {
-                tasks[newIdx].completed = !tasks[newIdx].completed;
-                SaveTasks();
-                InvalidateRect(hWnd, NULL, FALSE);
+            if (slotOffset == 0 && TapHitsIndicator(x)) {
+                int taskIdx = ViewToTask(newIdx);
+                if (ToggleTask(taskIdx)) {
+                    DropRowSprites(tasks[taskIdx].id);
+                    AppendJournal(JOP_SET_COMPLETED, tasks[taskIdx]);
+                }
+                InvalidateToggledRow(hWnd);
             } else {
                 selectedIndex = newIdx;
                 // Directly animate to the visual location tapped
-                targetScrollPos = newVisualTarget;
-                startScrollPos = visualScrollPos;
-                animStartTime = GetTickCount();
-                isAnimating = true;
-                SetTimer(hWnd, 1, 16, NULL);
+                ScrollToRow(newVisualRow, hWnd);
             }
             return 0;
         }
 
         case WM_CHAR:
+            if (IsLoadingTasks()) break; // Only the preview is there to edit
             if (currentMode == MODE_ADD) {
                 if (wParam == VK_RETURN) {
-                    currentMode = MODE_LIST;
-                    SaveTasks();
-                } else if (wParam == VK_BACK) {
-                    if (!tasks[selectedIndex].title.empty()) {
-                        tasks[selectedIndex].title.erase(tasks[selectedIndex].title.size() - 1);
-                    }
-                } else if (wParam >= 32) { // Printable characters
-                    tasks[selectedIndex].title += (wchar_t)wParam;
+                    CommitAddTask();
+                    AppendJournal(JOP_ADD, tasks[tasks.size() - 1]);
+                    ScheduleFrames(hWnd);
+                    InvalidateHeader(hWnd);
+                    InvalidateFooter(hWnd);
+                } else {
+                    EditSelectedTitle((wchar_t)wParam); // VK_BACK is L'\b'
                 }
-                InvalidateRect(hWnd, NULL, FALSE);
+                InvalidateRow(hWnd, 0);
+                return 0;
+            }
+            if (currentMode == MODE_SEARCH) {
+                if (EditSearchQuery((wchar_t)wParam)) InvalidateRect(hWnd, NULL, FALSE);
+                return 0;
+            }
+            // As a character rather than a key, so it does not also start the query
+            if (currentMode == MODE_LIST && (wParam == L'f' || wParam == L'F' || wParam == L'/')) {
+                BeginSearch();
+                InvalidateHeader(hWnd);
+                InvalidateFooter(hWnd);
                 return 0;
             }
             break;
 
         case WM_KEYDOWN:
+            if (IsLoadingTasks() && wParam != VK_ESCAPE) break;
             if (currentMode == MODE_LIST) {
-                if (tasks.empty() && wParam != 'A' && wParam != VK_ESCAPE) break;
+                if (tasks.empty() && (wParam == VK_UP || wParam == VK_DOWN || wParam == VK_RETURN || wParam == 'D' || wParam == VK_BACK ||
+                                      (wParam >= '1' && wParam <= '3') || wParam == 'T')) break;
                 switch (wParam) {
                     case VK_UP:
-                        selectedIndex = (selectedIndex <= 0) ? (int)tasks.size() - 1 : selectedIndex - 1;
-                        StartScrollAnimation(selectedIndex, hWnd);
+                        StepScroll(-1, wParam, hWnd);
                         break;
                     case VK_DOWN:
-                        selectedIndex = (selectedIndex >= (int)tasks.size() - 1) ? 0 : selectedIndex + 1;
-                        StartScrollAnimation(selectedIndex, hWnd);
+                        StepScroll(1, wParam, hWnd);
                         break;
-                    case VK_RETURN:
-                        if (selectedIndex >= 0 && selectedIndex < (int)tasks.size()) {
-                            tasks[selectedIndex].completed = !tasks[selectedIndex].completed;
-                            SaveTasks();
+                    case VK_RETURN: {
+                        int at = ViewToTask(selectedIndex);
+                        if (ToggleTask(at)) {
+                            DropRowSprites(tasks[at].id);
+                            AppendJournal(JOP_SET_COMPLETED, tasks[at]);
                         }
-                        InvalidateRect(hWnd, NULL, FALSE);
+                        InvalidateToggledRow(hWnd);
                         break;
+                    }
                     case 'A': // Add
-                        tasks.push_back(Task(L""));
-                        selectedIndex = (int)tasks.size() - 1;
-                        currentMode = MODE_ADD;
-                        visualScrollPos = targetScrollPos = (double)selectedIndex; // Snap for add
+                        BeginAddTask();
+                        RequestCaret(hWnd);
                         InvalidateRect(hWnd, NULL, FALSE);
                         break;
                     case 'D': // Delete
                     case VK_BACK:
                         if (selectedIndex >= 0 && selectedIndex < (int)tasks.size()) {
-                            tasks.erase(tasks.begin() + selectedIndex);
-                            if (selectedIndex >= (int)tasks.size()) selectedIndex = (int)tasks.size() - 1;
-                            if (selectedIndex < 0) selectedIndex = 0; // Handle case where all tasks are deleted
-                            visualScrollPos = targetScrollPos = (double)selectedIndex;
-                            SaveTasks();
+                            int at = ViewToTask(selectedIndex);
+                            Task removed = tasks[at];
+                            DropRowSprites(removed.id);
+                            EraseTask(at);
+                            AppendJournal(JOP_DELETE, removed); // After the erase, like every record
                             InvalidateRect(hWnd, NULL, TRUE);
                         }
                         break;
-                    case VK_ESCAPE:
-                        PostQuitMessage(0);
+                    case VK_LEFT: // Previous or next list
+                    case VK_RIGHT:
+                        SwitchList(StepList(wParam == VK_LEFT ? -1 : 1));
+                        DropAllRowSprites();
+                        InvalidateRect(hWnd, NULL, FALSE);
+                        break;
+                    case 'V': // Into or out of the archive
+                        SwitchList(lists[activeList].cold ? returnList : FindColdList());
+                        DropAllRowSprites();
+                        InvalidateRect(hWnd, NULL, FALSE);
+                        break;
+                    case 'X': // Archive completed tasks
+                        if (ArchiveCompleted()) {
+                            DropAllRowSprites();
+                            InvalidateRect(hWnd, NULL, FALSE);
+                        }
+                        break;
+                    case '1': // Priority, or clear it if the task already has it
+                    case '2':
+                    case '3': {
+                        int at = ViewToTask(selectedIndex);
+                        int priority = (int)(wParam - '0');
+                        if (SetTaskPriority(at, tasks[at].priority == priority ? 0 : priority)) CommitPlanChange(at, hWnd);
+                        break;
+                    }
+                    case 'T': { // Due today, tomorrow, in a week, none
+                        int at = ViewToTask(selectedIndex);
+                        if (SetTaskDue(at, NextDueDay(tasks[at].due))) CommitPlanChange(at, hWnd);
+                        break;
+                    }
+                    case 'O': // Next view order
+                        SetViewOrder((ViewOrder)((viewOrder + 1) % ORDER_COUNT));
+                        InvalidateRect(hWnd, NULL, FALSE);
+                        break;
+                    case 'S': // Sync with the other copies' delta files
+                        RunSync();
+                        SummarizeActiveList();
+                        DropAllRowSprites();
+                        InvalidateRect(hWnd, NULL, FALSE);
+                        break;
+                    case 'P': // Performance HUD, undocumented; hiding it writes perf.csv
+                        perfHudVisible = !perfHudVisible;
+                        if (perfHudVisible) {
+                            SetTimer(hWnd, PERF_HUD_TIMER, PERF_HUD_MS, NULL);
+                        } else {
+                            KillTimer(hWnd, PERF_HUD_TIMER);
+                            DumpPerfTrace();
+                        }
+                        InvalidateHeader(hWnd);
+                        break;
+                    case 'Z': // Undo
+                    case 'Y': // Redo
+                    {
+                        EditKind applied;
+                        Task t;
+                        if (wParam == 'Z' ? Undo(applied, t) : Redo(applied, t)) {
+                            if (applied == EDIT_ADD) AppendJournal(JOP_ADD, t);
+                            else if (applied == EDIT_DELETE) AppendJournal(JOP_DELETE, t);
+                            else AppendJournal(JOP_SET_COMPLETED, t);
+                            DropRowSprites(t.id);
+                            InvalidateRect(hWnd, NULL, TRUE);
+                        }
+                        break;
+                    }
+                    case VK_ESCAPE: // Through WM_DESTROY, which flushes the journal
+                        DestroyWindow(hWnd);
                         break;
                 }
             } else if (currentMode == MODE_ADD) {
                 if (wParam == VK_ESCAPE) {
-                    currentMode = MODE_LIST;
-                    if (tasks[selectedIndex].title.empty()) {
-                        tasks.erase(tasks.begin() + selectedIndex);
-                        selectedIndex = (int)tasks.size() - 1;
-                        if (selectedIndex < 0) selectedIndex = 0;
-                    }
-                    visualScrollPos = targetScrollPos = (double)selectedIndex;
+                    if (EndAddTask()) AppendJournal(JOP_ADD, tasks[tasks.size() - 1]);
+                    ScheduleFrames(hWnd);
                     InvalidateRect(hWnd, NULL, TRUE);
                 }
+            } else if (currentMode == MODE_SEARCH) {
+                switch (wParam) {
+                    case VK_UP:
+                        StepScroll(-1, wParam, hWnd);
+                        break;
+                    case VK_DOWN:
+                        StepScroll(1, wParam, hWnd);
+                        break;
+                    case VK_RETURN: // Jump to the match in the full list
+                    case VK_ESCAPE:
+                        EndSearch(wParam == VK_RETURN);
+                        InvalidateRect(hWnd, NULL, FALSE);
+                        break;
+                }
             }
             break;
 
@@ -364,136 +2245,75 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             return 1; // Handled
 
         case WM_PAINT: {
+            DWORD paintStart = PerfNow();
+            PerfRecord(PERF_FRAME_START, 0);
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hWnd, &ps);
 
             RECT rect;
             GetClientRect(hWnd, &rect);
-            if (rect.right == 0 || rect.bottom == 0) {
+            if (rect.right == 0 || rect.bottom == 0 || !hdcBack) {
                 EndPaint(hWnd, &ps);
                 return 0;
             }
 
-            HDC hdcMem = CreateCompatibleDC(hdc);
-            HBITMAP hbmMem = CreateCompatibleBitmap(hdc, rect.right, rect.bottom);
-            HBITMAP hbmOld = (HBITMAP)SelectObject(hdcMem, hbmMem);
-
-            HBRUSH bgBrush = CreateSolidBrush(CLR_BG);
-            FillRect(hdcMem, &rect, bgBrush);
-            DeleteObject(bgBrush);
-
-            SetBkMode(hdcMem, TRANSPARENT);
-
-            if (!tasks.empty()) {
-                int centerY = rect.bottom / 2;
-                int spacing = ITEM_HEIGHT + 2;
-                int halfItem = ITEM_HEIGHT / 2;
-                
-                double rangeJ = (double)rect.bottom / spacing / 2.0 + 1.5;
-                int startJ = (int)floor(visualScrollPos - rangeJ);
-                int endJ = (int)ceil(visualScrollPos + rangeJ);
-                int n = (int)tasks.size();
-
-                // Draw Stationary Focus Frame
-                RECT focusRect = { MARGIN_X, centerY - halfItem, rect.right - MARGIN_X, centerY - halfItem + ITEM_HEIGHT };
-                COLORREF highlightCol = (currentMode == MODE_ADD) ? RGB(60,20,20) : RGB(30,30,30);
-                DrawRoundedRect(hdcMem, focusRect, CORNER_RADIUS, CLR_GLASS_BORDER, highlightCol);
-
-                for (int j = startJ; j <= endJ; ++j) {
-                    int i = (j % n + n) % n;
-                    int itemTop = (int)(centerY - halfItem + (j - visualScrollPos) * spacing);
-                    RECT itemRect = { MARGIN_X, itemTop, rect.right - MARGIN_X, itemTop + ITEM_HEIGHT };
-
-                    // Seam Separator (between j=k*n-1 and j=k*n)
-                    if ((j % n == n - 1) && n > 1) {
-                        int seamY = itemTop + ITEM_HEIGHT + 1;
-                        if (seamY > MARGIN_Y && seamY < rect.bottom - MARGIN_Y) {
-                            HPEN hSeamPen = CreatePen(PS_SOLID, 1, RGB(60, 60, 60));
-                            HPEN hOldP = (HPEN)SelectObject(hdcMem, hSeamPen);
-                            MoveToEx(hdcMem, MARGIN_X, seamY, NULL); LineTo(hdcMem, rect.right - MARGIN_X, seamY);
-                            for (int dx = MARGIN_X; dx < rect.right - MARGIN_X; dx += 8) {
-                                SetPixel(hdcMem, dx, seamY - 2, CLR_TEXT_SEC); SetPixel(hdcMem, dx, seamY + 2, CLR_TEXT_SEC);
-                            }
-                            SelectObject(hdcMem, hOldP); DeleteObject(hSeamPen);
-                        }
-                    }
-
-
-
-                    if (itemTop + ITEM_HEIGHT < 0 || itemTop > rect.bottom) continue;
-
-                    // Indicator
-                    RECT checkRect = { itemRect.left + GRID_UNIT, itemRect.top + GRID_UNIT, 
-                                       itemRect.left + GRID_UNIT * 3, itemRect.top + ITEM_HEIGHT - GRID_UNIT };
-                    
-                    if (tasks[i].completed) {
-                        HBRUSH hBr = CreateSolidBrush(CLR_TEXT_PRI);
-                        HBRUSH hOldB = (HBRUSH)SelectObject(hdcMem, hBr);
-                        Ellipse(hdcMem, checkRect.left + 4, checkRect.top + 12, checkRect.right - 4, checkRect.bottom - 12);
-                        SelectObject(hdcMem, hOldB);
-                        DeleteObject(hBr);
-                    } else {
-                        HPEN hPen = CreatePen(PS_SOLID, 1, CLR_TEXT_SEC);
-                        HPEN hOldP = (HPEN)SelectObject(hdcMem, hPen);
-                        SelectObject(hdcMem, GetStockObject(NULL_BRUSH));
-                        Ellipse(hdcMem, checkRect.left + 4, checkRect.top + 12, checkRect.right - 4, checkRect.bottom - 12);
-                        SelectObject(hdcMem, hOldP);
-                        DeleteObject(hPen);
-                    }
+            // Everything below is clipped to the dirty rect; the rest of the
+            // back buffer still holds the previous frame.
+            RECT dirty = ps.rcPaint;
+            HDC hdcMem = hdcBack;
+            Canvas565& canvas = backCanvas;
+            IntersectClipRect(hdcMem, dirty.left, dirty.top, dirty.right, dirty.bottom);
+            canvas.SetClip(dirty.left, dirty.top, dirty.right, dirty.bottom);
+            SyncCanvas();
+
+            int gdiCreationsAtStart = gdiCreations;
+            GdiFrameSink sink(hdcMem, canvas);
+            LayoutRect dirtyLayout = MakeLayoutRect(dirty.left, dirty.top, dirty.right, dirty.bottom);
+            lastFrameStats = EmitFrame(sink, rect.right, rect.bottom, dirtyLayout, GetTickCount());
+
+            BitBlt(hdc, dirty.left, dirty.top, dirty.right - dirty.left, dirty.bottom - dirty.top, hdcMem, dirty.left, dirty.top, SRCCOPY);
+            SelectClipRgn(hdcMem, NULL);
+            canvas.ResetClip();
+            EndPaint(hWnd, &ps);
 
-                    // Text
-                    SelectObject(hdcMem, hFontMain);
-                    // Fade based on distance from screen center
-                    int distFromCenter = abs(itemTop + halfItem - centerY);
-                    int alpha = 255 - (distFromCenter * 255 / centerY);
-                    if (alpha < 40) alpha = 40;
-                    if (alpha > 255) alpha = 255;
-
-                    COLORREF baseCol = tasks[i].completed ? CLR_TEXT_SEC : CLR_TEXT_PRI;
-                    COLORREF fadedCol = RGB(GetRValue(baseCol) * alpha / 255, GetGValue(baseCol) * alpha / 255, GetBValue(baseCol) * alpha / 255);
-                    
-                    // Focused: virtual index j is the one closest to visualScrollPos
-                    bool isFocused = (j == (int)floor(visualScrollPos + 0.5));
-                    SetTextColor(hdcMem, isFocused ? baseCol : fadedCol);
-
-                    std::wstring displayText = tasks[i].title;
-                    if (isFocused && currentMode == MODE_ADD && (GetTickCount() / 500) % 2 == 0) {
-                        displayText += L"_";
-                    }
-                    RECT textRect = { itemRect.left + GRID_UNIT * 5, itemRect.top, itemRect.right, itemRect.bottom };
-                    DrawText(hdcMem, displayText.c_str(), -1, &textRect, DT_LEFT | DT_VCENTER | DT_SINGLELINE);
-                }
+            gdiCreationsLastFrame = gdiCreations - gdiCreationsAtStart;
+            PerfRecord(PERF_FRAME_END, PerfNow() - paintStart);
+            if (gdiCreationsLastFrame > 0) PerfRecord(PERF_GDI, (DWORD)gdiCreationsLastFrame);
+            MarkStartup(PHASE_FIRST_PAINT);
+            FinishStartupProfile();
+#ifdef TOFU_DEBUG_GDI
+            if (gdiCreationsLastFrame > 0) {
+                TCHAR msg[64];
+                wsprintf(msg, TEXT("GDI creations this frame: %d (total %d)\r\n"), gdiCreationsLastFrame, gdiCreations);
+                OutputDebugString(msg);
             }
-
-            // Header
-            SelectObject(hdcMem, hFontDot);
-            SetTextColor(hdcMem, CLR_TEXT_PRI);
-            SetBkMode(hdcMem, TRANSPARENT);
-            RECT headerRect = { MARGIN_X, MARGIN_Y / 2, rect.right - MARGIN_X, MARGIN_Y };
-            DrawText(hdcMem, (currentMode == MODE_ADD) ? TEXT("::: NEW TASK :::") : TEXT("::: TOFU MENTAL :::"), -1, &headerRect, DT_LEFT | DT_BOTTOM);
-
-            // Footer
-            SelectObject(hdcMem, hFontDot);
-            SetTextColor(hdcMem, CLR_TEXT_SEC);
-            TCHAR footerText[64];
-            wsprintf(footerText, TEXT("%s | ITEMS: %02d"), 
-                (currentMode == MODE_ADD) ? TEXT("INPUT") : TEXT("DEFAULT"), tasks.size());
-            RECT footerRect = { MARGIN_X, rect.bottom - 20, rect.right - MARGIN_X, rect.bottom - 5 };
-            DrawText(hdcMem, footerText, -1, &footerRect, DT_RIGHT | DT_SINGLELINE);
-
-            BitBlt(hdc, 0, 0, rect.right, rect.bottom, hdcMem, 0, 0, SRCCOPY);
-            SelectObject(hdcMem, hbmOld);
-            DeleteObject(hbmMem);
-            DeleteDC(hdcMem);
-            EndPaint(hWnd, &ps);
+#endif
             break;
         }
 
-        case WM_DESTROY:
+        case WM_ACTIVATE:
+            // Switched away from, the app may be ended without a WM_DESTROY
+            if (LOWORD(wParam) == WA_INACTIVE && !IsLoadingTasks()) {
+                FlushJournal();
+                SaveListState();
+                DumpPerfTrace();
+            }
+            break;
+
+        case WM_DESTROY: {
+            bool loaded = !IsLoadingTasks();
+            CancelLoadTasks();
+            CloseJournal();
+            if (loaded) SaveListState();
+            else SaveCatalog();
+            DumpPerfTrace();
+            DestroyBackBuffer();
+            ClearGdiCache();
             if (hFontMain) DeleteObject(hFontMain);
             if (hFontDot) DeleteObject(hFontDot);
             PostQuitMessage(0);
             break;
+        }
 
         default:
             return DefWindowProc(hWnd, uMsg, wParam, lParam);
@@ -502,6 +2322,7 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 }
 
 int WINAPI _tWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPTSTR lpCmdLine, int nShowCmd) {
+    MarkStartup(PHASE_PROCESS);
     UNREFERENCED_PARAMETER(hPrevInstance);
     UNREFERENCED_PARAMETER(lpCmdLine);
     UNREFERENCED_PARAMETER(nShowCmd);
@@ -0,0 +1,185 @@
+/*
+ * TofuMental - Canvas test.
+ * The word-at-a-time kernels against plain per-pixel loops, at every
+ * alignment and with clipping, and the shapes against golden images drawn
+ * as text: '.' black, '#' white, 'o' red.
+ */
+
+#include "canvas.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define WHITE RGB565(255, 255, 255)
+#define RED RGB565(255, 0, 0)
+
+struct TestCanvas {
+    TestCanvas(int w, int h) : bits(w * h, 0) { canvas.Attach(&bits[0], w, h, w); }
+    std::vector<Pixel565> bits;
+    Canvas565 canvas;
+};
+
+bool MatchesGolden(const Canvas565& c, const char* const* rows) {
+    for (int y = 0; y < c.Height(); ++y) {
+        for (int x = 0; x < c.Width(); ++x) {
+            Pixel565 p = c.Row(y)[x];
+            char want = rows[y][x];
+            if ((want == '.' && p != 0) || (want == '#' && p != WHITE) || (want == 'o' && p != RED)) {
+                printf("golden mismatch at %d,%d\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void TestGoldens() {
+    static const char* const fillCircle[] = {
+        "................",
+        ".....####.......",
+        "...########.....",
+        "...########.....",
+        "..##########....",
+        "..##########....",
+        "..##########....",
+        "..##########....",
+        "...########.....",
+        "...########.....",
+        ".....####.......",
+        "................",
+    };
+    static const char* const strokeCircle[] = {
+        "................",
+        ".....####.......",
+        "...##....##.....",
+        "...#......#.....",
+        "..#........#....",
+        "..#........#....",
+        "..#........#....",
+        "..#........#....",
+        "...#......#.....",
+        "...##....##.....",
+        ".....####.......",
+        "................",
+    };
+    static const char* const roundRect[] = {
+        "................",
+        "...##########...",
+        "..#oooooooooo#..",
+        ".#oooooooooooo#.",
+        ".#oooooooooooo#.",
+        ".#oooooooooooo#.",
+        ".#oooooooooooo#.",
+        ".#oooooooooooo#.",
+        ".#oooooooooooo#.",
+        "..#oooooooooo#..",
+        "...##########...",
+        "................",
+    };
+    static const char* const seam[] = {
+        "................",
+        "................",
+        "................",
+        ".o...o...o...o..",
+        "................",
+        ".##############.",
+        "................",
+        ".o...o...o...o..",
+        "................",
+        "................",
+        "................",
+        "................",
+    };
+
+    TestCanvas a(16, 12);
+    a.canvas.FillCircle(2, 1, 12, WHITE);
+    CHECK(MatchesGolden(a.canvas, fillCircle));
+    TestCanvas b(16, 12);
+    b.canvas.StrokeCircle(2, 1, 12, WHITE);
+    CHECK(MatchesGolden(b.canvas, strokeCircle));
+    TestCanvas c(16, 12);
+    c.canvas.FillRoundRect(1, 1, 15, 11, 4, RED, WHITE);
+    CHECK(MatchesGolden(c.canvas, roundRect));
+    TestCanvas d(16, 12);
+    d.canvas.DottedSeam(1, 15, 5, 4, WHITE, RED);
+    CHECK(MatchesGolden(d.canvas, seam));
+}
+
+Pixel565 RandomPixel() {
+    return (Pixel565)(rand() % 3 == 0 ? 0 : rand() & 0xFFFF); // Some black, which the blit skips
+}
+
+Pixel565 ReferenceFade(Pixel565 p, unsigned int fade) {
+    unsigned int r = (p >> 11) * fade >> 5;
+    unsigned int g = ((p >> 5) & 63) * fade >> 5;
+    unsigned int b = (p & 31) * fade >> 5;
+    return (Pixel565)((r << 11) | (g << 5) | b);
+}
+
+void TestFade() {
+    for (unsigned int fade = 0; fade <= FADE_ONE; ++fade) {
+        for (int k = 0; k < 2000; ++k) {
+            Pixel565 p = (Pixel565)(rand() & 0xFFFF);
+            CHECK(Fade565(p, fade) == ReferenceFade(p, fade));
+        }
+    }
+}
+
+// Spans and rects at every start and end alignment, clipped and not.
+void TestFills() {
+    const int w = 24;
+    const int h = 6;
+    for (int clip = 0; clip < 2; ++clip) {
+        for (int x0 = -2; x0 < w; ++x0) {
+            for (int x1 = x0; x1 <= w + 2; ++x1) {
+                TestCanvas t(w, h);
+                std::vector<Pixel565> expect(w * h, 0);
+                int cl = clip ? 3 : 0;
+                int cr = clip ? w - 5 : w;
+                if (clip) t.canvas.SetClip(cl, 1, cr, h - 1);
+                t.canvas.FillRect(x0, 0, x1, h, RED);
+                for (int y = clip ? 1 : 0; y < (clip ? h - 1 : h); ++y) {
+                    for (int x = x0 > cl ? x0 : cl; x < x1 && x < cr; ++x) expect[y * w + x] = RED;
+                }
+                CHECK(t.bits == expect);
+            }
+        }
+    }
+}
+
+void TestBlit() {
+    const int w = 20;
+    const int h = 4;
+    TestCanvas src(w, h);
+    for (size_t i = 0; i < src.bits.size(); ++i) src.bits[i] = RandomPixel();
+    for (int sx = 0; sx < 2; ++sx) {
+        for (int dx = -1; dx < 3; ++dx) {
+            for (int n = 0; n < w - 2; ++n) {
+                unsigned int fade = rand() % (FADE_ONE + 1);
+                if (n % 4 == 0) fade = FADE_ONE;
+                TestCanvas dst(w, h);
+                for (size_t i = 0; i < dst.bits.size(); ++i) dst.bits[i] = RandomPixel();
+                std::vector<Pixel565> expect = dst.bits;
+                for (int y = 0; y < h - 1; ++y) {
+                    for (int k = 0; k < n; ++k) {
+                        int x = dx + k;
+                        Pixel565 s = src.bits[(y + 1) * w + sx + k];
+                        if (x >= 0 && x < w && s) expect[y * w + x] |= ReferenceFade(s, fade);
+                    }
+                }
+                dst.canvas.OrBlitFaded(src.canvas, sx, 1, dx, 0, n, h - 1, fade);
+                CHECK(dst.bits == expect);
+            }
+        }
+    }
+}
+
+int main() {
+    srand(5);
+    TestGoldens();
+    TestFade();
+    TestFills();
+    TestBlit();
+    return CheckResult();
+}
@@ -0,0 +1,27 @@
+/*
+ * TofuMental - Host test support.
+ * CHECK reports a failed condition and carries on; a test's main returns
+ * CheckResult() so ctest sees any failure.
+ */
+
+#ifndef TOFU_CHECK_H
+#define TOFU_CHECK_H
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++checkFailures; \
+        } \
+    } while (0)
+
+static int CheckResult() {
+    if (checkFailures) printf("%d check(s) failed\n", checkFailures);
+    return checkFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ * TofuMental - File format test.
+ * Round trips through tasks.dat, tasks.txt and tasks.log encodings, version 3
+ * snapshots, and damaged files, which must be refused or cut at the damage.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <string.h>
+
+void ResetList() {
+    tasks.clear();
+    titleArena.clear();
+    nextTaskId = 1;
+}
+
+// A list with plans, empty titles, kana and separators in titles.
+void FillList() {
+    static const wchar_t* titles[] = { L"Eat Tofu", L"", L"\x8C46\x8150\x3092\x98DF\x3079\x308B", L"a|b", L"|", L"Stay Mental" };
+    ResetList();
+    for (size_t i = 0; i < 300; ++i) {
+        tasks.push_back(MakeTask(titles[i % 6]));
+        Task& t = tasks.back();
+        t.completed = i % 3 == 0;
+        t.priority = (unsigned char)(i % 4);
+        t.due = (unsigned short)(i % 5 ? 0 : 9000 + i);
+    }
+    nextTaskId += 7; // Ids given out to tasks since deleted
+}
+
+std::vector<Task> CopyList() {
+    std::vector<Task> copy;
+    for (size_t i = 0; i < tasks.size(); ++i) copy.push_back(tasks[i]);
+    return copy;
+}
+
+bool SameTasks(const std::vector<Task>& expect, bool plans) {
+    if (tasks.size() != expect.size()) return false;
+    for (size_t i = 0; i < expect.size(); ++i) {
+        const Task& a = tasks[i];
+        const Task& b = expect[i];
+        if (a.id != b.id || a.completed != b.completed || a.title.size() != b.title.size()) return false;
+        if (wcscmp(a.title.c_str(), b.title.c_str()) != 0) return false;
+        if (plans && (a.priority != b.priority || a.due != b.due)) return false;
+    }
+    return true;
+}
+
+void TestLayout() {
+    CHECK(sizeof(SnapshotHeader) == 24);
+    CHECK(sizeof(SnapshotRecord) == 16);
+    CHECK(sizeof(JournalRecord) == 8);
+    const unsigned char check[] = "123456789";
+    CHECK(Crc32(check, 9) == 0xCBF43926u);
+}
+
+void TestSnapshot() {
+    FillList();
+    std::vector<Task> before = CopyList();
+    unsigned long nextId = nextTaskId;
+    std::vector<unsigned char> data;
+    EncodeSnapshot(tasks, nextTaskId, data);
+
+    ResetList();
+    CHECK(DecodeSnapshot(&data[0], data.size()));
+    CHECK(SameTasks(before, true));
+    CHECK(nextTaskId == nextId);
+
+    // Any damaged byte, a short file or a long one is refused
+    for (size_t at = 0; at < data.size(); at += 37) {
+        std::vector<unsigned char> bad(data);
+        bad[at] ^= 0x40;
+        ResetList();
+        CHECK(!DecodeSnapshot(&bad[0], bad.size()));
+    }
+    ResetList();
+    CHECK(!DecodeSnapshot(&data[0], data.size() - 2));
+    data.push_back(0);
+    data.push_back(0);
+    CHECK(!DecodeSnapshot(&data[0], data.size()));
+    CHECK(tasks.size() == 0);
+}
+
+// A version 3 file is the same records cut short before due.
+void TestVersion3() {
+    FillList();
+    std::vector<Task> before = CopyList();
+    std::vector<unsigned char> v4;
+    EncodeSnapshot(tasks, nextTaskId, v4);
+    SnapshotHeader header;
+    memcpy(&header, &v4[0], sizeof(header));
+
+    size_t recordsEnd = sizeof(header) + header.count * sizeof(SnapshotRecord);
+    std::vector<unsigned char> v3(sizeof(header));
+    for (size_t i = 0; i < header.count; ++i) {
+        const unsigned char* rec = &v4[sizeof(header) + i * sizeof(SnapshotRecord)];
+        v3.insert(v3.end(), rec, rec + SNAPSHOT_V3_RECORD_BYTES);
+    }
+    v3.insert(v3.end(), v4.begin() + recordsEnd, v4.end());
+    header.version = 3;
+    header.crc = Crc32(&v3[sizeof(header)], v3.size() - sizeof(header));
+    memcpy(&v3[0], &header, sizeof(header));
+
+    for (size_t i = 0; i < before.size(); ++i) {
+        before[i].priority = 0;
+        before[i].due = 0;
+    }
+    ResetList();
+    CHECK(DecodeSnapshot(&v3[0], v3.size()));
+    CHECK(SameTasks(before, true));
+}
+
+void ParseText(const std::vector<unsigned char>& data) {
+    ResetList();
+    AppendArenaUnits(&data[0], data.size());
+    titleArena.push_back(L'\0');
+    ParseTextSnapshot(0);
+}
+
+void TestText() {
+    FillList();
+    std::vector<Task> before = CopyList();
+    unsigned long nextId = nextTaskId;
+    std::vector<unsigned char> data;
+    EncodeTextSnapshot(tasks, nextTaskId, data);
+    ParseText(data);
+    CHECK(SameTasks(before, false));
+    CHECK(nextTaskId == nextId);
+
+    // A legacy file: no version line or ids, the last '|' is the flag's
+    const wchar_t legacy[] = L"\xFEFF" L"Eat Tofu|1\r\n\r\nno separator\nx|y|0\r";
+    std::vector<unsigned char> bytes;
+    for (size_t i = 0; legacy[i]; ++i) {
+        bytes.push_back((unsigned char)legacy[i]);
+        bytes.push_back((unsigned char)(legacy[i] >> 8));
+    }
+    ParseText(bytes);
+    CHECK(tasks.size() == 2);
+    CHECK(wcscmp(tasks[0].title.c_str(), L"Eat Tofu") == 0 && tasks[0].completed && tasks[0].id == 1);
+    CHECK(wcscmp(tasks[1].title.c_str(), L"x|y") == 0 && !tasks[1].completed && tasks[1].id == 2);
+}
+
+void TestJournal() {
+    FillList();
+    std::vector<unsigned char> log;
+    for (size_t i = 0; i < tasks.size(); ++i) EncodeJournalRecord(JOP_ADD, tasks[i], log);
+    for (size_t i = 0; i < tasks.size(); i += 4) {
+        tasks[i].completed = !tasks[i].completed;
+        EncodeJournalRecord(JOP_SET_COMPLETED, tasks[i], log);
+    }
+    tasks[5].title = TaskTitle(L"renamed");
+    EncodeJournalRecord(JOP_SET_TITLE, tasks[5], log);
+    tasks[6].priority = 3;
+    tasks[6].due = 12345;
+    EncodeJournalRecord(JOP_SET_PLAN, tasks[6], log);
+    Task gone = tasks[7];
+    tasks.erase(7);
+    EncodeJournalRecord(JOP_DELETE, gone, log);
+    std::vector<Task> after = CopyList();
+    unsigned long nextId = tasks.back().id + 1;
+
+    ResetList();
+    std::map<unsigned long, size_t> index;
+    CHECK(ReplayJournalRecords(&log[0], log.size(), index) == log.size());
+    std::vector<Task> live;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (tasks[i].id) live.push_back(tasks[i]);
+    }
+    tasks.clear();
+    for (size_t i = 0; i < live.size(); ++i) tasks.push_back(live[i]);
+    CHECK(SameTasks(after, true));
+    CHECK(nextTaskId == nextId);
+
+    // A torn tail or a damaged record stops the replay at the record before
+    size_t firstBytes = sizeof(JournalRecord) + tasks[0].title.size() * 2 + 4;
+    ResetList();
+    index.clear();
+    CHECK(ReplayJournalRecords(&log[0], log.size() - 1, index) < log.size() - 1);
+    std::vector<unsigned char> bad(log);
+    bad[firstBytes + 5] ^= 1;
+    ResetList();
+    index.clear();
+    CHECK(ReplayJournalRecords(&bad[0], bad.size(), index) == firstBytes);
+    CHECK(tasks.size() == 1);
+}
+
+int main() {
+    TestLayout();
+    TestSnapshot();
+    TestVersion3();
+    TestText();
+    TestJournal();
+    return CheckResult();
+}
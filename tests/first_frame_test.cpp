@@ -0,0 +1,96 @@
+/*
+ * TofuMental - Time to first frame test.
+ * Goes from a tasks.dat of 10 to 100k tasks to the first frame the way the
+ * window does at start-up: the header, the preview's records and titles,
+ * then a full frame. The bytes read and the allocations must not grow with
+ * the list; the rest of it loads after the frame is up. The time is reported
+ * but not checked, being at the mercy of the machine's load.
+ */
+
+#include "core.h"
+#include "check.h"
+#include "../bench/bench.h"
+#include <string.h>
+
+#define SCREEN_W 480
+#define SCREEN_H 272
+#define RUNS 200
+#define SIZE_COUNT 4
+
+static const size_t sizes[SIZE_COUNT] = { 10, 1000, 10000, 100000 };
+
+class CountingSink : public FrameSink {
+public:
+    CountingSink() : rows(0) {}
+    void Background(const LayoutRect&) {}
+    void FocusFrame(const LayoutRect&, bool) {}
+    void Seam(int, int, int) {}
+    void Indicator(const LayoutRect&, bool) {}
+    void RowTitle(const LayoutRect&, const Task&, int, bool, bool) { ++rows; }
+    void Header(const LayoutRect&, AppMode, const wchar_t*, const wchar_t*) {}
+    void Footer(const LayoutRect&, AppMode, size_t) {}
+
+    int rows;
+};
+
+// Stands in for the open snapshot, counting what is read from it.
+class MemoryReader : public SnapshotReader {
+public:
+    explicit MemoryReader(const std::vector<unsigned char>& file) : file(file), bytesRead(0) {}
+    bool ReadAt(size_t offset, void* buffer, size_t bytes) {
+        if (offset + bytes > file.size()) return false;
+        memcpy(buffer, &file[offset], bytes);
+        bytesRead += bytes;
+        return true;
+    }
+
+    const std::vector<unsigned char>& file;
+    size_t bytesRead;
+};
+
+// Returns the rows the first frame drew.
+int FirstFrame(MemoryReader& reader) {
+    tasks.clear();
+    ResetViewIndex();
+    SnapshotHeader header;
+    CHECK(reader.ReadAt(0, &header, sizeof(header)));
+    size_t recordBytes = CheckSnapshotHeader(header, reader.file.size());
+    CHECK(recordBytes != 0);
+    LoadSnapshotPreview(header, recordBytes, reader);
+    SnapScroll(0);
+    CountingSink sink;
+    EmitFrame(sink, SCREEN_W, SCREEN_H, MakeLayoutRect(0, 0, SCREEN_W, SCREEN_H), 1000);
+    return sink.rows;
+}
+
+int main() {
+    double micros[SIZE_COUNT];
+    unsigned long allocs[SIZE_COUNT];
+    size_t bytes[SIZE_COUNT];
+    for (int s = 0; s < SIZE_COUNT; ++s) {
+        BenchList(sizes[s]);
+        std::vector<unsigned char> snapshot;
+        EncodeSnapshot(tasks, nextTaskId, snapshot);
+
+        micros[s] = 0;
+        for (int run = 0; run < RUNS; ++run) {
+            MemoryReader reader(snapshot);
+            unsigned long before = benchAllocs;
+            double start = BenchMicros();
+            int rows = FirstFrame(reader);
+            double elapsed = BenchMicros() - start;
+            if (run == 0 || elapsed < micros[s]) micros[s] = elapsed;
+            allocs[s] = benchAllocs - before;
+            bytes[s] = reader.bytesRead;
+            CHECK(rows > 0);
+        }
+        CHECK(tasks.size() == (sizes[s] < 2 * LOAD_PREVIEW_ROWS ? sizes[s] : 2 * LOAD_PREVIEW_ROWS));
+        printf("%6lu tasks: %6.1f us, %5lu bytes read, %3lu allocs\n", (unsigned long)sizes[s], micros[s],
+               (unsigned long)bytes[s], allocs[s]);
+    }
+    for (int s = 2; s < SIZE_COUNT; ++s) {
+        CHECK(bytes[s] <= bytes[1] + 2 * LOAD_PREVIEW_ROWS * 4); // Longer "Task <i>" titles
+        CHECK(allocs[s] <= allocs[1]);
+    }
+    return CheckResult();
+}
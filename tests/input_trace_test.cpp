@@ -0,0 +1,179 @@
+/*
+ * TofuMental - Input trace test.
+ * Replays recorded-style input traces, a held arrow key, key repeats queued
+ * behind slow frames, flicks, a flick across the wrap and a tap, through the
+ * core the way the window delivers them, one frame at a time. Reports the
+ * input-to-settle latency of each and checks where the wheel lands, that a
+ * held key never makes it stall or back up, and how far it may trail.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <stdlib.h>
+
+#define LIST_ROWS 500
+#define SCREEN_H 272
+#define REPEAT_MS 33 // Typematic rate of a held key
+#define MAX_KEY_LAG INT_TO_FIX(4) // Rows a held key may leave the wheel behind
+
+enum EventKind { EV_KEY, EV_PRESS, EV_MOVE, EV_RELEASE };
+
+struct TraceEvent {
+    unsigned long time;
+    EventKind kind;
+    int value; // Direction for a key, stylus y otherwise
+};
+
+struct Trace {
+    const char* name;
+    unsigned long frameMs; // Slow frames let key repeats queue up
+    int startRow;
+    long startFraction; // 24.8 rows past startRow: a wheel caught mid-scroll
+    std::vector<TraceEvent> events;
+};
+
+struct TraceResult {
+    unsigned long lastInput;
+    unsigned long settled; // 0 if it never did
+    long maxLag;           // Of the wheel behind its target, while keys were held
+    bool backedUp;         // The wheel moved against the keys
+    int keySteps;          // Net rows the keys asked for
+};
+
+void AddEvent(Trace& t, unsigned long time, EventKind kind, int value) {
+    TraceEvent e = { time, kind, value };
+    t.events.push_back(e);
+}
+
+Trace KeyHold(const char* name, unsigned long frameMs, int direction, int repeats) {
+    Trace t = { name, frameMs, 10, 0, std::vector<TraceEvent>() };
+    for (int i = 0; i < repeats; ++i) AddEvent(t, 1000 + i * REPEAT_MS, EV_KEY, direction);
+    return t;
+}
+
+// A stroke from y0 to y1 over `ms`, lifted after `hold` ms still.
+Trace Stroke(const char* name, int startRow, int y0, int y1, unsigned long ms, unsigned long hold) {
+    Trace t = { name, 16, startRow, 0, std::vector<TraceEvent>() };
+    AddEvent(t, 1000, EV_PRESS, y0);
+    for (unsigned long dt = 8; dt <= ms; dt += 8) AddEvent(t, 1000 + dt, EV_MOVE, y0 + (int)((y1 - y0) * (long)dt / (long)ms));
+    AddEvent(t, 1000 + ms + hold, EV_RELEASE, y1);
+    return t;
+}
+
+// Signed distance from a to b the short way round the list, 24.8 rows.
+long WrappedDelta(long a, long b) {
+    long lap = INT_TO_FIX(LIST_ROWS);
+    long d = (b - a) % lap;
+    if (d > lap / 2) d -= lap;
+    if (d < -lap / 2) d += lap;
+    return d;
+}
+
+// Delivers each event at the first frame at or after it, as the message
+// queue would, with a frame's key repeats applied as one step.
+TraceResult Replay(const Trace& trace) {
+    TraceResult r = { 0, 0, 0, false, 0 };
+    selectedIndex = trace.startRow;
+    SnapScroll(trace.startRow);
+    visualScrollPos = targetScrollPos = INT_TO_FIX(trace.startRow) + trace.startFraction;
+    isAnimating = false;
+    size_t next = 0;
+    for (unsigned long now = 1000; now < 10000; now += trace.frameMs) {
+        int keys = 0;
+        for (; next < trace.events.size() && trace.events[next].time <= now; ++next) {
+            const TraceEvent& e = trace.events[next];
+            r.lastInput = now;
+            if (e.kind == EV_KEY) keys += e.value;
+            else if (e.kind == EV_PRESS) BeginDrag(e.value, now);
+            else if (e.kind == EV_MOVE) DragTo(e.value, now);
+            else EndDrag(e.value, now);
+        }
+        if (keys != 0) {
+            r.keySteps += keys;
+            if (StepSelection(keys)) ScrollTowardIndex(selectedIndex, now);
+        }
+
+        long before = visualScrollPos;
+        bool moving = TickScroll(now);
+        if (r.keySteps != 0) {
+            long moved = WrappedDelta(before, visualScrollPos);
+            if ((r.keySteps > 0 && moved < 0) || (r.keySteps < 0 && moved > 0)) r.backedUp = true;
+            long lag = abs(WrappedDelta(visualScrollPos, targetScrollPos));
+            if (lag > r.maxLag) r.maxLag = lag;
+        }
+        if (!moving && !IsDragging() && next == trace.events.size()) {
+            r.settled = now;
+            break;
+        }
+    }
+    return r;
+}
+
+// Settled on a whole row in [0, n) with the selection under the frame.
+bool SettledOnRow() {
+    return !isAnimating && visualScrollPos == targetScrollPos && targetScrollPos % FIX_ONE == 0 &&
+           targetScrollPos >= 0 && targetScrollPos < INT_TO_FIX(LIST_ROWS) &&
+           selectedIndex == FIX_FLOOR(targetScrollPos);
+}
+
+void Report(const Trace& trace, const TraceResult& r) {
+    printf("%-16s settle %4lu ms after input, row %3d\n", trace.name, r.settled ? r.settled - r.lastInput : 0,
+           selectedIndex);
+}
+
+void TestKeys() {
+    Trace traces[] = {
+        KeyHold("hold down", 16, 1, 90),
+        KeyHold("hold up", 16, -1, 90),
+        KeyHold("slow frames", 120, 1, 90), // Repeats queue four deep
+    };
+    for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); ++i) {
+        TraceResult r = Replay(traces[i]);
+        Report(traces[i], r);
+        CHECK(r.settled != 0);
+        CHECK(r.settled - r.lastInput <= (unsigned long)ANIM_DURATION + traces[i].frameMs);
+        CHECK(SettledOnRow());
+        CHECK(selectedIndex == WrapIndex(traces[i].startRow + r.keySteps, LIST_ROWS));
+        CHECK(!r.backedUp);
+        CHECK(r.maxLag <= MAX_KEY_LAG + (long)(traces[i].frameMs / REPEAT_MS) * FIX_ONE);
+    }
+}
+
+void TestStylus() {
+    // Stylus up moves the wheel to later rows
+    Trace flickUp = Stroke("flick", 200, 220, 60, 80, 0);
+    Trace flickWrap = Stroke("flick over wrap", 2, 60, 220, 80, 0);
+    Trace heldDrag = Stroke("drag and hold", 200, 220, 60, 80, 200);
+    Trace tap = Stroke("tap", 200, 100, 100, 0, 60);
+    tap.startFraction = FIX_ONE / 3;
+
+    TraceResult r = Replay(flickUp);
+    Report(flickUp, r);
+    CHECK(r.settled != 0 && r.settled - r.lastInput <= FLICK_MAX_MS + 16);
+    CHECK(SettledOnRow());
+    CHECK(selectedIndex > 200 + (220 - 60) / ROW_SPACING); // Coasted past where the stylus left it
+
+    r = Replay(flickWrap);
+    Report(flickWrap, r);
+    CHECK(r.settled != 0 && r.settled - r.lastInput <= FLICK_MAX_MS + 16);
+    CHECK(SettledOnRow());
+    CHECK(selectedIndex > LIST_ROWS / 2); // Went back across row 0
+
+    r = Replay(heldDrag);
+    Report(heldDrag, r);
+    CHECK(r.settled != 0 && r.settled - r.lastInput <= (unsigned long)ANIM_DURATION + 16);
+    CHECK(SettledOnRow());
+    CHECK(abs(selectedIndex - (200 + (220 - 60) / ROW_SPACING)) <= 1); // No coast
+
+    r = Replay(tap);
+    Report(tap, r);
+    CHECK(r.settled != 0 && r.settled - r.lastInput <= (unsigned long)ANIM_DURATION + 16);
+    CHECK(SettledOnRow());
+}
+
+int main() {
+    for (int i = 0; i < LIST_ROWS; ++i) tasks.push_back(MakeTask(L"Row"));
+    TestKeys();
+    TestStylus();
+    return CheckResult();
+}
@@ -0,0 +1,127 @@
+/*
+ * TofuMental - Scroll trajectory test.
+ * Drives the fixed-point scroll animation with single steps and with random
+ * bursts of retargets, and follows a double-precision model of the same
+ * impulses alongside, built on the pow() ease-out the wheel used before.
+ * Every millisecond the two must agree to within a pixel.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define LIST_ROWS 1000
+#define MAX_ERROR_PX 1.0
+
+struct DoubleImpulse {
+    double delta; // Rows
+    unsigned long startTime;
+};
+
+// The reference: what GetScrollPosition computes, in double.
+struct DoubleScroll {
+    double target;
+    std::vector<DoubleImpulse> impulses;
+
+    static double Remaining(unsigned long elapsed) {
+        if (elapsed >= (unsigned long)ANIM_DURATION) return 0;
+        return pow(1.0 - (double)elapsed / ANIM_DURATION, 3);
+    }
+
+    void Retarget(double to, unsigned long now) {
+        double delta = to - target;
+        if (delta == 0) return;
+        target = to;
+        if (!impulses.empty() && impulses.back().startTime == now) {
+            impulses.back().delta += delta;
+            return;
+        }
+        if (impulses.size() == 16) {
+            delta += impulses[0].delta * Remaining(now - impulses[0].startTime);
+            impulses.erase(impulses.begin());
+        }
+        DoubleImpulse d = { delta, now };
+        impulses.push_back(d);
+    }
+
+    double Position(unsigned long now) const {
+        double pos = target;
+        for (size_t k = 0; k < impulses.size(); ++k) pos -= impulses[k].delta * Remaining(now - impulses[k].startTime);
+        return pos;
+    }
+};
+
+double worstErrorPx = 0;
+
+// Pixels between the fixed-point wheel and the reference, modulo a lap.
+double ErrorPx(const DoubleScroll& ref, unsigned long now) {
+    double lap = LIST_ROWS;
+    double diff = (double)visualScrollPos / FIX_ONE - ref.Position(now);
+    diff -= lap * floor(diff / lap + 0.5);
+    return fabs(diff) * ROW_SPACING;
+}
+
+void Reset(DoubleScroll& ref) {
+    SnapScroll(0);
+    isAnimating = false;
+    ref.target = 0;
+    ref.impulses.clear();
+}
+
+// Steps by `rows` at `now` on both.
+void Step(DoubleScroll& ref, int rows, unsigned long now) {
+    ScrollTowardRow(FIX_FLOOR(targetScrollPos) + rows, now);
+    ref.Retarget(ref.target + rows, now);
+}
+
+void Follow(DoubleScroll& ref, unsigned long from, unsigned long to) {
+    for (unsigned long now = from; now < to; ++now) {
+        TickScroll(now);
+        double error = ErrorPx(ref, now);
+        if (error > worstErrorPx) worstErrorPx = error;
+        CHECK(error <= MAX_ERROR_PX);
+        if (error > MAX_ERROR_PX) return;
+    }
+}
+
+void TestSingleSteps() {
+    static const int steps[] = { 1, -1, 3, -7, 40, -120, 499 };
+    DoubleScroll ref;
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+        Reset(ref);
+        Step(ref, steps[i], 1000);
+        Follow(ref, 1000, 1000 + ANIM_DURATION + 10);
+        CHECK(!isAnimating);
+        CHECK(FIX_FLOOR(targetScrollPos) == ((steps[i] % LIST_ROWS) + LIST_ROWS) % LIST_ROWS);
+    }
+}
+
+// Key repeat, taps and jumps, with several retargets in one tick at times.
+void TestRandomBursts() {
+    DoubleScroll ref;
+    srand(5);
+    for (int trial = 0; trial < 200; ++trial) {
+        Reset(ref);
+        unsigned long now = 1000;
+        int retargets = 1 + rand() % 40;
+        for (int k = 0; k < retargets; ++k) {
+            int kind = rand() % 10;
+            int rows = kind < 6 ? (rand() % 2 ? 1 : -1) : kind < 9 ? rand() % 7 - 3 : rand() % 200 - 100;
+            Step(ref, rows, now);
+            unsigned long gap = rand() % 4 == 0 ? 0 : rand() % 60;
+            Follow(ref, now, now + gap);
+            now += gap;
+        }
+        Follow(ref, now, now + ANIM_DURATION + 10);
+        CHECK(!isAnimating);
+    }
+}
+
+int main() {
+    for (int i = 0; i < LIST_ROWS; ++i) tasks.push_back(MakeTask(L"Row"));
+    TestSingleSteps();
+    TestRandomBursts();
+    printf("worst error %.3f px\n", worstErrorPx);
+    return CheckResult();
+}
@@ -0,0 +1,64 @@
+/*
+ * TofuMental - Search test.
+ * Random queries over a list that is added to and deleted from between
+ * searches, against a plain scan of the titles.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <stdlib.h>
+
+// Folded the way the search folds: fullwidth ASCII to ASCII, then A-Z to a-z.
+std::wstring Fold(const wchar_t* s) {
+    std::wstring out;
+    for (; *s; ++s) {
+        wchar_t c = *s;
+        if (c >= 0xFF01 && c <= 0xFF5E) c = (wchar_t)(c - 0xFEE0);
+        if (c >= L'A' && c <= L'Z') c = (wchar_t)(c + (L'a' - L'A'));
+        out += c;
+    }
+    return out;
+}
+
+std::wstring RandomTitle() {
+    static const wchar_t letters[] = L"abcABC\xFF41\xFF22xy";
+    std::wstring s;
+    int len = 1 + rand() % 8;
+    for (int k = 0; k < len; ++k) s += letters[rand() % 10];
+    return s;
+}
+
+void CheckQuery(const std::wstring& query) {
+    BeginSearch();
+    for (size_t k = 0; k < query.size(); ++k) {
+        EditSearchQuery(query[k]);
+        std::wstring folded = Fold(query.substr(0, k + 1).c_str());
+        std::vector<int> expect;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            if (Fold(tasks[i].title.c_str()).find(folded) != std::wstring::npos) expect.push_back((int)i);
+        }
+        bool same = ViewSize() == expect.size();
+        for (size_t j = 0; same && j < expect.size(); ++j) same = ViewToTask((int)j) == expect[j];
+        CHECK(same);
+    }
+    EndSearch(false);
+}
+
+int main() {
+    srand(3);
+    for (int i = 0; i < 2000; ++i) tasks.push_back(MakeTask(RandomTitle()));
+    for (int round = 0; round < 200; ++round) {
+        for (int k = 0; k < 5; ++k) {
+            if (rand() % 2 && !tasks.empty()) {
+                EraseTask(rand() % tasks.size());
+            } else {
+                BeginAddTask();
+                std::wstring title = RandomTitle();
+                for (size_t c = 0; c < title.size(); ++c) EditSelectedTitle(title[c]);
+                CommitAddTask();
+            }
+        }
+        CheckQuery(RandomTitle());
+    }
+    return CheckResult();
+}
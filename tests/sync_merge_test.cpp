@@ -0,0 +1,176 @@
+/*
+ * TofuMental - Sync merge test.
+ * Two copies of one list make random edits and merge each other's deltas in
+ * random order, stale and repeated ones included. Once each has merged the
+ * other's latest delta, both must hold the same tasks.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <stdlib.h>
+#include <algorithm>
+
+#define TRIALS 300
+#define STEPS 300
+
+// A copy's state while another copy is in the core's globals.
+struct Replica {
+    TaskStore tasks;
+    unsigned long nextId;
+    unsigned long replica;
+    unsigned long clock;
+    std::vector<SyncEntry> entries;
+    std::vector<SyncPeer> peers;
+    std::vector<Task> deleted; // For re-adding, as an undone delete does
+};
+
+struct Delta {
+    unsigned long from;
+    unsigned long clock;
+    unsigned long ack;
+    std::vector<SyncRecord> records;
+};
+
+Replica copies[2];
+std::vector<Delta> written[2]; // Every delta each copy has written, oldest first
+
+void Enter(Replica& r) {
+    tasks.swap(r.tasks);
+    nextTaskId = r.nextId;
+    syncReplica = r.replica;
+    syncClock = r.clock;
+    syncEntries.swap(r.entries);
+    syncPeers.swap(r.peers);
+}
+
+void Leave(Replica& r) {
+    tasks.swap(r.tasks);
+    r.nextId = nextTaskId;
+    r.replica = syncReplica;
+    r.clock = syncClock;
+    syncEntries.swap(r.entries);
+    syncPeers.swap(r.peers);
+    tasks.clear();
+}
+
+// The delta copy k would write for the other copy now.
+Delta WriteDelta(int k) {
+    Delta d;
+    Enter(copies[k]);
+    d.from = syncReplica;
+    d.clock = syncClock;
+    d.ack = 0;
+    for (size_t i = 0; i < syncPeers.size(); ++i) {
+        if (syncPeers[i].replica == copies[1 - k].replica) d.ack = syncPeers[i].seen;
+    }
+    CollectSyncDelta(d.records);
+    Leave(copies[k]);
+    written[k].push_back(d);
+    return d;
+}
+
+void MergeDelta(int k, const Delta& d) {
+    std::vector<SyncChange> changes;
+    Enter(copies[k]);
+    MergeSyncDelta(d.from, d.clock, d.ack, d.records, changes);
+    Leave(copies[k]);
+}
+
+void RandomEdit(Replica& r) {
+    Enter(r);
+    int op = rand() % 10;
+    if (op < 3 || tasks.empty()) {
+        wchar_t title[16];
+        swprintf(title, 16, L"t%d", rand() % 50);
+        tasks.push_back(MakeTask(title));
+        NoteSyncEdit(SYNC_ADD, tasks.back());
+    } else if (op < 6) {
+        int i = rand() % tasks.size();
+        ToggleTask(i);
+        NoteSyncEdit(SYNC_COMPLETED, tasks[i]);
+    } else if (op < 8) {
+        int i = rand() % tasks.size();
+        Task t = tasks[i];
+        EraseTask(i);
+        NoteSyncEdit(SYNC_DELETE, t);
+        r.deleted.push_back(t);
+    } else if (op < 9) {
+        int i = rand() % tasks.size();
+        tasks[i].title.Edit() += L'x';
+        NoteSyncEdit(SYNC_TITLE, tasks[i]);
+    } else if (!r.deleted.empty()) {
+        // Back in its place in id order, unless a merge brought it back already
+        Task t = r.deleted.back();
+        r.deleted.pop_back();
+        size_t at = 0;
+        while (at < tasks.size() && tasks[at].id < t.id) ++at;
+        if (at == tasks.size() || tasks[at].id != t.id) {
+            tasks.insert(at, t);
+            NoteSyncEdit(SYNC_ADD, t);
+        }
+    }
+    Leave(r);
+}
+
+// Titles with their completion, sorted: ids are local to each copy.
+std::vector<std::wstring> Contents(Replica& r) {
+    std::vector<std::wstring> v;
+    Enter(r);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        v.push_back(std::wstring(tasks[i].title.c_str()) + (tasks[i].completed ? L"+" : L"-"));
+        if (i > 0) CHECK(tasks[i].id > tasks[i - 1].id);
+    }
+    Leave(r);
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+void RunTrial(int trial) {
+    srand(trial);
+    for (int k = 0; k < 2; ++k) {
+        copies[k] = Replica();
+        written[k].clear();
+        // The same list in both copies, already diverged a little before sync
+        for (int i = 0; i < 5; ++i) {
+            Task t(L"legacy");
+            t.id = i + 1;
+            t.completed = k == 0 && i == 1;
+            copies[k].tasks.push_back(t);
+        }
+        copies[k].nextId = 6;
+        Enter(copies[k]);
+        EnableSync(0x80000001 + k);
+        Leave(copies[k]);
+    }
+
+    for (int step = 0; step < STEPS; ++step) {
+        int k = rand() % 2;
+        int event = rand() % 4;
+        if (event < 2) {
+            RandomEdit(copies[k]);
+        } else if (event == 2) {
+            WriteDelta(k);
+        } else if (!written[1 - k].empty()) {
+            // Usually the latest, sometimes one merged already or superseded
+            size_t n = written[1 - k].size();
+            MergeDelta(k, written[1 - k][rand() % 3 ? n - 1 : rand() % n]);
+        }
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        MergeDelta(1, WriteDelta(0));
+        MergeDelta(0, WriteDelta(1));
+    }
+    std::vector<std::wstring> first = Contents(copies[0]);
+    bool same = Contents(copies[1]) == first;
+    if (!same) printf("trial %d: the copies differ\n", trial);
+    CHECK(same);
+
+    // With nothing new, a delta carries nothing
+    CHECK(WriteDelta(0).records.empty());
+}
+
+int main() {
+    for (int trial = 0; trial < TRIALS; ++trial) RunTrial(trial);
+    return CheckResult();
+}
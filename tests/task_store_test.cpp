@@ -0,0 +1,96 @@
+/*
+ * TofuMental - TaskStore test.
+ * Random inserts, erases and lookups against a plain vector, and the reload
+ * and swap patterns that once left a stale lookup hint behind.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <stdlib.h>
+
+// The store must list exactly the ids in expect, in order.
+bool SameIds(const TaskStore& store, const std::vector<unsigned long>& expect) {
+    if (store.size() != expect.size()) return false;
+    for (size_t i = 0; i < expect.size(); ++i) {
+        if (store[i].id != expect[i]) return false;
+    }
+    return true;
+}
+
+void FillStore(TaskStore& store, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        Task t;
+        t.id = i + 1;
+        store.push_back(t);
+    }
+}
+
+void TestRefillAfterClear() {
+    TaskStore store;
+    FillStore(store, 200);
+    CHECK(store[150].id == 151); // Leaves the hint on a chunk past the first
+    store.clear();
+    FillStore(store, 200);
+    for (size_t i = 0; i < store.size(); ++i) CHECK(store[i].id == i + 1);
+
+    // The same through a backward walk, which misses the hint every time
+    store.clear();
+    FillStore(store, 200);
+    for (size_t i = store.size(); i-- > 0;) CHECK(store[i].id == i + 1);
+}
+
+// swap() leaves no hint, as the index one past the last chunk; appending a
+// chunk must not turn that into a hint for it.
+void TestAppendAfterSwap() {
+    TaskStore store;
+    FillStore(store, 10);
+    TaskStore other;
+    other.swap(store);
+    for (size_t i = 10; i < 200; ++i) {
+        Task t;
+        t.id = i + 1;
+        other.push_back(t);
+    }
+    for (size_t i = 0; i < other.size(); ++i) CHECK(other[i].id == i + 1);
+}
+
+void TestRandomEdits() {
+    TaskStore store;
+    std::vector<unsigned long> expect;
+    unsigned long nextId = 1;
+    srand(9);
+    for (int step = 0; step < 20000; ++step) {
+        int op = rand() % 8;
+        if (op < 4 || expect.empty()) {
+            size_t pos = rand() % (expect.size() + 1);
+            Task t;
+            t.id = nextId++;
+            store.insert(pos, t);
+            expect.insert(expect.begin() + pos, t.id);
+        } else if (op < 7) {
+            size_t pos = rand() % expect.size();
+            store.erase(pos);
+            expect.erase(expect.begin() + pos);
+        } else {
+            size_t pos = rand() % expect.size();
+            CHECK(store[pos].id == expect[pos]);
+        }
+        if (step % 1000 == 0) {
+            CHECK(SameIds(store, expect));
+            TaskStore copy(store);
+            CHECK(SameIds(copy, expect));
+        }
+        if (step % 5000 == 4999) {
+            store.clear();
+            expect.clear();
+        }
+    }
+    CHECK(SameIds(store, expect));
+}
+
+int main() {
+    TestRefillAfterClear();
+    TestAppendAfterSwap();
+    TestRandomEdits();
+    return CheckResult();
+}
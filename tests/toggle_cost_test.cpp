@@ -0,0 +1,71 @@
+/*
+ * TofuMental - Toggle cost test.
+ * Times what the UI thread does for one toggle, as WM_KEYDOWN does it: the
+ * view lookup, ToggleTask, the sync stamp and the journal record queued for
+ * the writer thread. With a view order and sync on, over 1000 to 100k tasks,
+ * the allocations per toggle must stay the same. The time is reported with
+ * its growth per tenfold list, which stays well under the tenfold of
+ * anything linear, but not checked: a loaded machine makes it noisy.
+ */
+
+#include "core.h"
+#include "check.h"
+#include "../bench/bench.h"
+#include <stdlib.h>
+
+#define TOGGLES 20000
+#define RUNS 5
+#define SIZE_COUNT 3
+
+static const size_t sizes[SIZE_COUNT] = { 1000, 10000, 100000 };
+
+std::vector<unsigned char> journalQueue; // The writer thread's queue, drained every batch
+
+struct ToggleCost {
+    double nanos;
+    double allocs;
+};
+
+// One toggle as the window makes it, less the painting.
+void ToggleAndQueue(int row) {
+    int at = ViewToTask(row);
+    if (!ToggleTask(at)) return;
+    NoteSyncEdit(SYNC_COMPLETED, tasks[at]);
+    std::vector<unsigned char> buf;
+    EncodeJournalRecord(JOP_SET_COMPLETED, tasks[at], buf);
+    journalQueue.insert(journalQueue.end(), buf.begin(), buf.end());
+    if (journalQueue.size() > 4096) journalQueue.clear();
+}
+
+ToggleCost MeasureToggles(size_t n) {
+    BenchList(n);
+    EnableSync(0x80000001ul);
+    SetViewOrder(ORDER_OPEN_FIRST);
+    journalQueue.reserve(8192);
+    srand(11);
+    for (int i = 0; i < 1000; ++i) ToggleAndQueue(rand() % (int)n); // Warm the view and undo log
+
+    ToggleCost best = { 0, 0 };
+    for (int run = 0; run < RUNS; ++run) {
+        std::vector<int> rows(TOGGLES);
+        for (int i = 0; i < TOGGLES; ++i) rows[i] = rand() % (int)n;
+        unsigned long allocs = benchAllocs;
+        double start = BenchMicros();
+        for (int i = 0; i < TOGGLES; ++i) ToggleAndQueue(rows[i]);
+        double nanos = (BenchMicros() - start) * 1000 / TOGGLES;
+        if (run == 0 || nanos < best.nanos) best.nanos = nanos;
+        best.allocs = (double)(benchAllocs - allocs) / TOGGLES;
+    }
+    return best;
+}
+
+int main() {
+    ToggleCost costs[SIZE_COUNT];
+    for (int s = 0; s < SIZE_COUNT; ++s) {
+        costs[s] = MeasureToggles(sizes[s]);
+        printf("%6lu tasks: %7.1f ns/toggle (x%.1f), %.2f allocs/toggle\n", (unsigned long)sizes[s], costs[s].nanos,
+               s > 0 ? costs[s].nanos / costs[s - 1].nanos : 1.0, costs[s].allocs);
+    }
+    for (int s = 1; s < SIZE_COUNT; ++s) CHECK(costs[s].allocs <= costs[0].allocs);
+    return CheckResult();
+}
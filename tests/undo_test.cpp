@@ -0,0 +1,148 @@
+/*
+ * TofuMental - Undo test.
+ * Thousands of random toggles, deletes, adds, undos and redos, in random view
+ * orders, checked after every step against the list as it stood at that
+ * point in the history. Each run is then undone to its start, which must
+ * give back the original list, and redone to its end.
+ */
+
+#include "core.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIALS 40
+#define STEPS 150 // Few enough that the undo log never drops an entry
+#define START_TASKS 40
+
+std::vector<Task> CopyList() {
+    std::vector<Task> copy;
+    for (size_t i = 0; i < tasks.size(); ++i) copy.push_back(tasks[i]);
+    return copy;
+}
+
+bool SameList(const std::vector<Task>& expect) {
+    if (tasks.size() != expect.size()) return false;
+    for (size_t i = 0; i < expect.size(); ++i) {
+        const Task& a = tasks[i];
+        const Task& b = expect[i];
+        if (a.id != b.id || a.completed != b.completed || a.priority != b.priority || a.due != b.due) return false;
+        if (a.title.size() != b.title.size() || wcscmp(a.title.c_str(), b.title.c_str()) != 0) return false;
+    }
+    return true;
+}
+
+// The view must map rows to tasks and back one to one.
+bool ViewConsistent() {
+    if (ViewSize() != tasks.size()) return false;
+    for (size_t j = 0; j < tasks.size(); j += 7) {
+        int at = ViewToTask((int)j);
+        if (at < 0 || TaskToView(at) != (int)j) return false;
+    }
+    return true;
+}
+
+void FillList() {
+    tasks.clear();
+    titleArena.clear();
+    ResetSearchIndex();
+    ResetViewIndex();
+    ResetUndo();
+    viewOrder = ORDER_LIST;
+    currentMode = MODE_LIST;
+    selectedIndex = 0;
+    nextTaskId = 1;
+    SnapScroll(0);
+    for (int i = 0; i < START_TASKS; ++i) {
+        tasks.push_back(MakeTask(L"Start"));
+        tasks.back().completed = rand() % 2 == 0;
+        tasks.back().priority = (unsigned char)(rand() % 4);
+        tasks.back().due = (unsigned short)(rand() % 3 ? 0 : 9000 + rand() % 30);
+    }
+}
+
+// Makes one random edit; false if it made none.
+bool RandomEdit() {
+    int kind = rand() % 3;
+    if (kind == 0 && !tasks.empty()) return ToggleTask(ViewToTask(rand() % (int)ViewSize()));
+    if (kind == 1 && !tasks.empty()) return EraseTask(ViewToTask(rand() % (int)ViewSize()));
+    BeginAddTask();
+    int len = 1 + rand() % 8;
+    for (int c = 0; c < len; ++c) EditSelectedTitle((wchar_t)(L'a' + rand() % 26));
+    if (rand() % 4 == 0) EditSelectedTitle(L'\b');
+    CommitAddTask();
+    return true;
+}
+
+void RunTrial() {
+    FillList();
+    // history[k] is the list after k edits; cursor is where undo has us
+    std::vector<std::vector<Task> > history(1, CopyList());
+    size_t cursor = 0;
+    for (int step = 0; step < STEPS; ++step) {
+        int action = rand() % 10;
+        EditKind kind;
+        Task task;
+        if (action == 0) {
+            SetViewOrder((ViewOrder)(rand() % ORDER_COUNT));
+        } else if (action <= 2) {
+            CHECK(Undo(kind, task) == (cursor > 0));
+            if (cursor > 0) --cursor;
+        } else if (action == 3) {
+            CHECK(Redo(kind, task) == (cursor + 1 < history.size()));
+            if (cursor + 1 < history.size()) ++cursor;
+        } else if (RandomEdit()) {
+            history.resize(++cursor);
+            history.push_back(CopyList());
+            CHECK(!CanRedo());
+        }
+        CHECK(SameList(history[cursor]));
+        CHECK(ViewConsistent());
+        if (checkFailures) return;
+    }
+
+    EditKind kind;
+    Task task;
+    while (Undo(kind, task)) --cursor;
+    CHECK(cursor == 0);
+    CHECK(SameList(history[0]));
+    while (Redo(kind, task)) ++cursor;
+    CHECK(cursor + 1 == history.size());
+    CHECK(SameList(history.back()));
+    CHECK(ViewConsistent());
+}
+
+// Past UNDO_LOG_BYTES the oldest edits go, but undo must still reach a
+// state the list really was in.
+void TestEviction() {
+    FillList();
+    std::vector<std::vector<Task> > history(1, CopyList());
+    while (history.size() < 2000) {
+        ToggleTask(rand() % (int)tasks.size());
+        history.push_back(CopyList());
+    }
+    EditKind kind;
+    Task task;
+    size_t cursor = history.size() - 1;
+    while (Undo(kind, task)) --cursor;
+    CHECK(cursor > 0);
+    CHECK(SameList(history[cursor]));
+}
+
+// A title longer than an entry can hold must not come back shortened.
+void TestLongTitle() {
+    FillList();
+    ToggleTask(0);
+    tasks.push_back(MakeTask(std::wstring(0x10000 + 5, L'x')));
+    CHECK(EraseTask((int)tasks.size() - 1));
+    CHECK(!CanUndo());
+    CHECK(tasks.size() == START_TASKS);
+}
+
+int main() {
+    srand(13);
+    for (int trial = 0; trial < TRIALS && !checkFailures; ++trial) RunTrial();
+    TestEviction();
+    TestLongTitle();
+    return CheckResult();
+}
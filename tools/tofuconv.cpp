@@ -0,0 +1,71 @@
+/*
+ * TofuMental - Snapshot converter.
+ * Turns a tasks.txt into a tasks.dat and back, through the same encoders
+ * and decoders the app uses, so a list can be edited or inspected on a
+ * desktop. Which way it goes follows the input's extension. Text has no room
+ * for plans: priorities and due days are dropped on the way to .txt.
+ */
+
+#include "core.h"
+#include <stdio.h>
+#include <string.h>
+
+bool ReadFileBytes(const char* path, std::vector<unsigned char>& data) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    unsigned char buf[64 * 1024];
+    size_t n;
+    data.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+bool WriteFileBytes(const char* path, const std::vector<unsigned char>& data) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = data.empty() || fwrite(&data[0], 1, data.size(), f) == data.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool EndsWith(const char* s, const char* suffix) {
+    size_t n = strlen(s);
+    size_t k = strlen(suffix);
+    return n >= k && strcmp(s + n - k, suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: tofuconv <in.txt> <out.dat>\n       tofuconv <in.dat> <out.txt>\n");
+        return 2;
+    }
+
+    std::vector<unsigned char> in;
+    if (!ReadFileBytes(argv[1], in)) {
+        fprintf(stderr, "tofuconv: cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<unsigned char> out;
+    if (EndsWith(argv[1], ".dat")) {
+        if (!DecodeSnapshot(in.empty() ? NULL : &in[0], in.size())) {
+            fprintf(stderr, "tofuconv: %s is not a valid snapshot\n", argv[1]);
+            return 1;
+        }
+        EncodeTextSnapshot(tasks, nextTaskId, out);
+    } else {
+        AppendArenaUnits(in.empty() ? NULL : &in[0], in.size());
+        titleArena.push_back(L'\0');
+        ParseTextSnapshot(0);
+        EncodeSnapshot(tasks, nextTaskId, out);
+    }
+
+    if (!WriteFileBytes(argv[2], out)) {
+        fprintf(stderr, "tofuconv: cannot write %s\n", argv[2]);
+        return 1;
+    }
+    printf("%lu tasks, %lu -> %lu bytes\n", (unsigned long)tasks.size(), (unsigned long)in.size(),
+           (unsigned long)out.size());
+    return 0;
+}